@@ -0,0 +1,150 @@
+#include "Bench.hpp"
+#include "Bank.hpp"
+#include "Journal.hpp"
+#include "WriteBehindQueue.hpp"
+#include "../server/RequestHandler.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+
+// Counts heap allocations made by the request path. bank_bench replaces the
+// global operator new, so every allocation on the calling thread bumps a
+// counter; the server binary keeps the default allocator.
+
+namespace {
+    thread_local uint64_t allocations = 0;
+
+    void* allocate(std::size_t size){
+        ++allocations;
+        if(void* p = std::malloc(size ? size : 1)){
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t align){
+        ++allocations;
+        std::size_t alignment = static_cast<std::size_t>(align);
+        // aligned_alloc wants a size that is a multiple of the alignment
+        std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+        if(void* p = std::aligned_alloc(alignment, rounded ? rounded : alignment)){
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size){ return allocate(size); }
+void* operator new[](std::size_t size){ return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try{ return allocate(size); }catch(...){ return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try{ return allocate(size); }catch(...){ return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t align){ return allocateAligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align){ return allocateAligned(size, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+    constexpr int ACCOUNTS = 1000;
+    constexpr int FIRST_ACCOUNT = 900000;
+    constexpr size_t REQUESTS = 100000;
+
+    // Sends one request frame per iteration through handleFrame, reusing one
+    // output buffer the way a connection does, and reports allocations per
+    // request once the buffers, pools and journal are warm. The DEPOSIT and
+    // WITHDRAW paths are meant to be allocation-free, so any allocation is
+    // reported as a failure.
+    template <typename MakeFrame>
+    void measure(const std::string& bench, const std::string& param, Session& session, MakeFrame&& makeFrame){
+        std::string frame;
+        std::string out;
+        for(size_t i = 0; i < 1000; ++i){
+            makeFrame(i, frame);
+            handleFrame(session, frame, out);
+            out.clear();
+        }
+
+        uint64_t before = allocations;
+        auto start = BenchClock::now();
+        for(size_t i = 0; i < REQUESTS; ++i){
+            makeFrame(i, frame);
+            handleFrame(session, frame, out);
+            out.clear();
+        }
+        double ns = elapsedNs(start);
+        uint64_t after = allocations;
+
+        reportResult(bench, param, static_cast<double>(after - before) / REQUESTS, "allocs/request");
+        reportResult(bench + "_latency", param, ns / REQUESTS, "ns/request");
+        if(after != before){
+            reportFailure(bench, param, std::to_string(after - before) + " allocations in " + std::to_string(REQUESTS) + " requests");
+        }
+    }
+}
+
+void openBenchBank(int firstAccount, int count){
+    // no Redis needed: the write-behind worker never wakes up during the run
+    // (configure restarts its wait under these settings)
+    WriteBehindConfig wb;
+    wb.flushInterval = std::chrono::hours(1);
+    wb.maxBatch = SIZE_MAX;
+    WriteBehindQueue::getInstance().configure(wb);
+
+    // an unsynced, never-checkpointed journal, unlinked so nothing is left behind
+    JournalConfig config;
+    config.path = (std::filesystem::temp_directory_path() / "bank_bench_requests.journal").string();
+    config.policy = FsyncPolicy::NONE;
+    config.checkpointBytes = SIZE_MAX;
+    std::remove(config.path.c_str());
+    Journal::getInstance().open(config);
+    std::remove(config.path.c_str());
+
+    Bank& bank = Bank::getInstance();
+    for(int i = 0; i < count; ++i){
+        bank.createAccount(i % 2 ? AccountType::CHECKING : AccountType::SAVINGS, firstAccount + i,
+                           "bench", money::fromUnits(1000000), 0, 100);
+    }
+}
+
+void runAllocBench(){
+    openBenchBank(FIRST_ACCOUNT, ACCOUNTS);
+
+    for(Opcode op : {Opcode::DEPOSIT, Opcode::WITHDRAW}){
+        Session binary;
+        binary.binary = true;
+        measure("alloc_binary", op == Opcode::DEPOSIT ? "op=DEPOSIT" : "op=WITHDRAW", binary,
+                [op](size_t i, std::string& frame){
+            BinaryRequest req;
+            req.op = op;
+            req.accountNumber = FIRST_ACCOUNT + static_cast<int>(i % ACCOUNTS);
+            req.amount = 1;
+            frame.clear();
+            encodeRequest(req, frame);
+        });
+    }
+
+    for(const char* action : {"DEPOSIT", "WITHDRAW"}){
+        Session text;
+        measure("alloc_json", std::string("op=") + action, text,
+                [action](size_t i, std::string& frame){
+            frame = "{\"action\":\"";
+            frame += action;
+            frame += "\",\"accountNumber\":\"";
+            char buf[16];
+            frame.append(buf, static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%d", FIRST_ACCOUNT + static_cast<int>(i % ACCOUNTS))));
+            frame += "\",\"amount\":\"0.01\"}";
+        });
+    }
+
+}
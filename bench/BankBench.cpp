@@ -0,0 +1,91 @@
+#include "Bench.hpp"
+#include "RedisCache.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <functional>
+
+namespace {
+    void usage(const char* prog){
+        std::cerr << "Usage: " << prog << " [--format text|csv|json] [--redis-server PATH] [--redis-port N] [--list] [name...]\n"
+                  << "  runs every benchmark when no names are given\n"
+                  << "  --format        result lines as 'bench param value unit' (default), CSV or JSON lines\n"
+                  << "  --redis-server  redis-server binary the redis benchmark spawns (default: from PATH)\n"
+                  << "  --redis-port    port for that private server (default 6399)\n";
+    }
+}
+
+int main(int argc, char* argv[]){
+    const std::map<std::string, std::function<void()>> benches = {
+        {"alloc", runAllocBench},
+        {"bank", runBankOpsBench},
+        {"decode", runDecodeBench},
+        {"dispatch", runDispatchBench},
+        {"fields", runFieldsBench},
+        {"index", runIndexBench},
+        {"interest", runInterestBench},
+        {"journal", runJournalBench},
+        {"network", runNetworkBench},
+        {"redis", runRedisBench},
+        {"registry", runRegistryBench},
+        {"serialize", runSerializeBench},
+        {"server", runServerBench},
+        {"snapshot", runSnapshotBench}
+    };
+
+    BenchOptions& options = benchOptions();
+    std::vector<std::string> names;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--format" && i + 1 < argc){
+            std::string format = argv[++i];
+            if(format == "text"){
+                options.format = BenchFormat::TEXT;
+            }else if(format == "csv"){
+                options.format = BenchFormat::CSV;
+            }else if(format == "json"){
+                options.format = BenchFormat::JSON;
+            }else{
+                usage(argv[0]);
+                return 1;
+            }
+        }else if(arg == "--redis-server" && i + 1 < argc){
+            options.redisServer = argv[++i];
+        }else if(arg == "--redis-port" && i + 1 < argc){
+            options.redisPort = std::atoi(argv[++i]);
+        }else if(arg == "--list"){
+            for(const auto& entry : benches){
+                std::cout << entry.first << "\n";
+            }
+            return 0;
+        }else if(arg.rfind("--", 0) == 0){
+            usage(argv[0]);
+            return 1;
+        }else if(benches.count(arg) == 0){
+            std::cerr << "Unknown benchmark '" << arg << "'\n";
+            return 1;
+        }else{
+            names.push_back(arg);
+        }
+    }
+
+    // anything a benchmark writes to Redis goes to the private bench server
+    RedisCache::configure(RedisConfig{"127.0.0.1", options.redisPort});
+
+    if(options.format == BenchFormat::CSV){
+        std::cout << "bench,param,value,unit\n";
+    }
+
+    // bank_bench [name...] - runs every benchmark when no names are given
+    if(names.empty()){
+        for(const auto& [name, run] : benches){
+            run();
+        }
+        return benchFailures() ? 1 : 0;
+    }
+
+    for(const auto& name : names){
+        benches.at(name)();
+    }
+    return benchFailures() ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+#include "Bench.hpp"
+#include "Bank.hpp"
+
+// Single-threaded cost of the Bank operations behind each request, measured
+// as the table grows, so lookups and locking that degrade with the account
+// count show up. The journal is unsynced and write-behind held back, so this
+// is the in-memory path plus one journal write per mutation.
+
+namespace {
+    constexpr int FIRST_ACCOUNT = 10000000;
+    constexpr size_t OPS = 100000;
+    const int COUNTS[] = {1000, 10000, 100000, 1000000};
+
+    template <typename Op>
+    void timeOp(const std::string& op, int count, Op&& fn){
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        auto start = BenchClock::now();
+        for(size_t i = 0; i < OPS; ++i){
+            int accNum = FIRST_ACCOUNT + static_cast<int>(nextRandom(state) % static_cast<uint64_t>(count));
+            fn(accNum);
+        }
+        double ns = elapsedNs(start);
+        reportResult("bank_" + op, "accounts=" + std::to_string(count), ns / OPS, "ns/op");
+    }
+}
+
+void runBankOpsBench(){
+    Bank& bank = Bank::getInstance();
+    int created = 0;
+
+    for(int count : COUNTS){
+        auto start = BenchClock::now();
+        openBenchBank(FIRST_ACCOUNT + created, count - created);
+        reportResult("bank_create", "accounts=" + std::to_string(count), elapsedNs(start) / (count - created), "ns/op");
+        created = count;
+
+        timeOp("find", count, [&bank](int accNum){
+            doNotOptimize(bank.findAccount(accNum));
+        });
+        timeOp("deposit", count, [&bank](int accNum){
+            doNotOptimize(bank.depositBalance(accNum, 100));
+        });
+        timeOp("withdraw", count, [&bank](int accNum){
+            doNotOptimize(bank.withdrawBalance(accNum, 100));
+        });
+        timeOp("transfer", count, [&bank, count](int accNum){
+            int other = FIRST_ACCOUNT + (accNum - FIRST_ACCOUNT + 1) % count;
+            doNotOptimize(bank.transfer(other, accNum, 100));
+        });
+        timeOp("display_one", count, [&bank](int accNum){
+            doNotOptimize(bank.displayAccount(accNum));
+        });
+    }
+}
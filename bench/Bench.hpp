@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+// Small helpers shared by the bank_bench microbenchmarks.
+
+using BenchClock = std::chrono::steady_clock;
+
+inline double elapsedNs(BenchClock::time_point start){
+    return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count();
+}
+
+enum class BenchFormat{
+    TEXT, // "bench param value unit", one result per line
+    CSV,  // the same four columns under a header row
+    JSON  // one {"bench", "param", "value", "unit"} object per line
+};
+
+// Command-line settings shared by every benchmark
+struct BenchOptions{
+    BenchFormat format = BenchFormat::TEXT;
+    std::string redisServer = "redis-server"; // spawned by the redis benchmark
+    int redisPort = 6399; // bench traffic never goes to the default 6379
+};
+
+inline BenchOptions& benchOptions(){
+    static BenchOptions options;
+    return options;
+}
+
+// Params are "key=value" strings without commas, so results can be compared
+// across runs and releases by (bench, param)
+inline void reportResult(const std::string& bench, const std::string& param, double value, const std::string& unit){
+    switch(benchOptions().format){
+        case BenchFormat::TEXT:
+            std::cout << bench << " " << param << " " << value << " " << unit << "\n";
+            break;
+        case BenchFormat::CSV:
+            std::cout << bench << "," << param << "," << value << "," << unit << "\n";
+            break;
+        case BenchFormat::JSON:
+            std::cout << nlohmann::json{{"bench", bench}, {"param", param}, {"value", value}, {"unit", unit}}.dump() << "\n";
+            break;
+    }
+}
+
+// xorshift64* - cheap, reproducible pseudo-random keys for lookups
+inline uint64_t nextRandom(uint64_t& state){
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+// Benchmarks that also check a property (no allocations, say) report a
+// violation here; bank_bench exits nonzero if there was any
+inline int& benchFailures(){
+    static int failures = 0;
+    return failures;
+}
+
+inline void reportFailure(const std::string& bench, const std::string& param, const std::string& what){
+    std::cerr << "FAILED " << bench << " " << param << ": " << what << "\n";
+    ++benchFailures();
+}
+
+// Keeps the optimizer from discarding benchmark results
+template <typename T>
+inline void doNotOptimize(const T& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs Bank against a throwaway journal with write-behind held back (no
+// Redis needed) and creates count accounts from firstAccount
+void openBenchBank(int firstAccount, int count);
+
+void runAllocBench();
+void runBankOpsBench();
+void runDecodeBench();
+void runDispatchBench();
+void runFieldsBench();
+void runIndexBench();
+void runNetworkBench();
+void runRedisBench();
+void runRegistryBench();
+void runSerializeBench();
+void runServerBench();
+void runInterestBench();
+void runJournalBench();
+void runSnapshotBench();
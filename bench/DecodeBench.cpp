@@ -0,0 +1,117 @@
+#include "Bench.hpp"
+#include "Bank.hpp"
+#include "RequestDecoder.hpp"
+#include "../server/RequestHandler.hpp"
+#include <vector>
+
+// JSON requests per second on one core, end to end through handleFrame
+// (decode, bank operation, journal append, response) for a mix of the
+// common single-account actions, and the cost of decoding alone: a DOM
+// parse plus the old string checks and std::stol, against the one-pass
+// decoder with std::from_chars.
+
+namespace {
+    constexpr int ACCOUNTS = 1000;
+    constexpr int FIRST_ACCOUNT = 800000;
+    constexpr size_t REQUESTS = 200000;
+
+    std::vector<std::string> requestMix(){
+        std::vector<std::string> frames;
+        for(int i = 0; i < ACCOUNTS; ++i){
+            std::string a = std::to_string(FIRST_ACCOUNT + i);
+            std::string b = std::to_string(FIRST_ACCOUNT + (i + 1) % ACCOUNTS);
+            switch(i % 4){
+                case 0:
+                    frames.push_back(R"({"action":"DEPOSIT","accountNumber":")" + a + R"(","amount":"12.50"})");
+                    break;
+                case 1:
+                    frames.push_back(R"({"action":"WITHDRAW","accountNumber":")" + a + R"(","amount":"2.25"})");
+                    break;
+                case 2:
+                    frames.push_back(R"({"action":"TRANSFER","accountNumber1":")" + a + R"(","accountNumber2":")" + b + R"(","amount":"1"})");
+                    break;
+                default:
+                    frames.push_back(R"({"action":"DISPLAY_ONE","accountNumber":")" + a + R"("})");
+                    break;
+            }
+        }
+        return frames;
+    }
+
+    // What handleRequest and validateJsonField did per request before the decoder
+    int64_t decodeWithDom(const std::string& frame){
+        json req = json::parse(frame);
+        std::string action = req.at("action");
+        int64_t sum = static_cast<int64_t>(action.size());
+        for(const char* key : {"accountNumber", "accountNumber1", "accountNumber2"}){
+            if(req.contains(key)){
+                std::string text = req[key].get<std::string>();
+                if(text.find_first_not_of("-0123456789") == std::string::npos){
+                    size_t pos = 0;
+                    sum += std::stol(text, &pos);
+                }
+            }
+        }
+        if(req.contains("amount")){
+            Money amount = 0;
+            money::parse(req["amount"].get_ref<const std::string&>(), amount);
+            sum += amount;
+        }
+        return sum;
+    }
+
+    int64_t decodeInPlace(const std::string& frame){
+        RequestDecoder decoder;
+        if(!decoder.parse(frame)){
+            return 0;
+        }
+        int64_t sum = static_cast<int64_t>(decoder.find("action")->value.size());
+        for(const char* key : {"accountNumber", "accountNumber1", "accountNumber2"}){
+            int accNum = 0;
+            if(const RequestDecoder::Field* field = decoder.find(key)){
+                fields::parseInt(field->value, accNum);
+                sum += accNum;
+            }
+        }
+        if(const RequestDecoder::Field* field = decoder.find("amount")){
+            Money amount = 0;
+            fields::parseAmount(field->value, amount);
+            sum += amount;
+        }
+        return sum;
+    }
+
+    template <typename Decode>
+    void timeDecode(const std::string& design, const std::vector<std::string>& frames, Decode&& decode){
+        int64_t sum = 0;
+        auto start = BenchClock::now();
+        for(size_t i = 0; i < REQUESTS; ++i){
+            sum += decode(frames[i % frames.size()]);
+        }
+        double ns = elapsedNs(start);
+        doNotOptimize(sum);
+        reportResult("decode_parse", "design=" + design, ns / REQUESTS, "ns/request");
+    }
+}
+
+void runDecodeBench(){
+    openBenchBank(FIRST_ACCOUNT, ACCOUNTS);
+    std::vector<std::string> frames = requestMix();
+
+    timeDecode("dom", frames, decodeWithDom);
+    timeDecode("decoder", frames, decodeInPlace);
+
+    Session session;
+    std::string out;
+    size_t responseBytes = 0;
+    auto start = BenchClock::now();
+    for(size_t i = 0; i < REQUESTS; ++i){
+        handleFrame(session, frames[i % frames.size()], out);
+        responseBytes += out.size();
+        out.clear();
+    }
+    double seconds = elapsedNs(start) / 1e9;
+    doNotOptimize(responseBytes);
+
+    reportResult("decode_e2e", "mix=deposit/withdraw/transfer/display_one", REQUESTS / seconds, "requests/s/core");
+}
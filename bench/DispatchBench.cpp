@@ -0,0 +1,111 @@
+#include "Bench.hpp"
+#include "AccountDispatch.hpp"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr int ACCOUNTS = 1000000;
+
+    // The account classes as they were before the type tag: type by virtual
+    // call returning a string, subclass fields reached through dynamic_cast
+    class LegacyAccount{
+    public:
+        explicit LegacyAccount(Money balance) : balance(balance) {}
+        virtual ~LegacyAccount() = default;
+        virtual std::string getAccountType() const = 0;
+        virtual bool canWithdrawLocked(Money amount) const = 0;
+        Money balance;
+    };
+
+    class LegacySavings : public LegacyAccount{
+    public:
+        LegacySavings(Money balance, Rate rate) : LegacyAccount(balance), interestRate(rate) {}
+        std::string getAccountType() const override { return "SAVINGS"; }
+        bool canWithdrawLocked(Money amount) const override { return balance - amount >= 0; }
+        Rate interestRate;
+    };
+
+    class LegacyChecking : public LegacyAccount{
+    public:
+        LegacyChecking(Money balance, int limit) : LegacyAccount(balance), overdraftLimit(limit) {}
+        std::string getAccountType() const override { return "CHECKING"; }
+        bool canWithdrawLocked(Money amount) const override { return balance + money::fromUnits(overdraftLimit) - amount >= 0; }
+        int overdraftLimit;
+    };
+
+    template <typename Fn>
+    void timePerAccount(const std::string& bench, const std::string& design, Fn&& fn){
+        auto start = BenchClock::now();
+        fn();
+        reportResult(bench, "design=" + design, elapsedNs(start) / ACCOUNTS, "ns/account");
+    }
+}
+
+void runDispatchBench(){
+    // a shuffled half/half mix, so the type branch is not trivially predicted
+    std::vector<bool> savings(ACCOUNTS);
+    for(int i = 0; i < ACCOUNTS; ++i){
+        savings[i] = i % 2 == 0;
+    }
+    std::shuffle(savings.begin(), savings.end(), std::mt19937_64(42));
+
+    std::vector<std::shared_ptr<LegacyAccount>> legacy;
+    std::vector<std::shared_ptr<Account>> tagged;
+    legacy.reserve(ACCOUNTS);
+    tagged.reserve(ACCOUNTS);
+    for(int i = 0; i < ACCOUNTS; ++i){
+        if(savings[i]){
+            legacy.push_back(std::make_shared<LegacySavings>(money::fromUnits(1000), 100));
+            tagged.push_back(std::make_shared<SavingsAccount>(i, "bench", money::fromUnits(1000), 100));
+        }else{
+            legacy.push_back(std::make_shared<LegacyChecking>(money::fromUnits(1000), 500));
+            tagged.push_back(std::make_shared<CheckingAccount>(i, "bench", money::fromUnits(1000), 500));
+        }
+    }
+
+    // Type check plus a subclass field, as modify/interest/save used to do it
+    timePerAccount("dispatch_type_field", "string_dynamic_cast", [&](){
+        int64_t sum = 0;
+        for(const auto& acc : legacy){
+            if(acc->getAccountType() == "SAVINGS"){
+                sum += dynamic_cast<const LegacySavings&>(*acc).interestRate;
+            }else if(acc->getAccountType() == "CHECKING"){
+                sum += dynamic_cast<const LegacyChecking&>(*acc).overdraftLimit;
+            }
+        }
+        doNotOptimize(sum);
+    });
+    timePerAccount("dispatch_type_field", "type_tag", [&](){
+        int64_t sum = 0;
+        for(const auto& acc : tagged){
+            sum += visitAccount(std::as_const(*acc), [](const auto& typed) -> int64_t {
+                if constexpr (std::is_same_v<std::decay_t<decltype(typed)>, SavingsAccount>){
+                    return typed.getInterestRateLocked();
+                }else{
+                    return typed.getOverDraftLimitLocked();
+                }
+            });
+        }
+        doNotOptimize(sum);
+    });
+
+    // A type-specific operation (the withdraw/transfer check)
+    const Money amount = money::fromUnits(1200);
+    timePerAccount("dispatch_can_withdraw", "virtual", [&](){
+        size_t allowed = 0;
+        for(const auto& acc : legacy){
+            allowed += acc->canWithdrawLocked(amount);
+        }
+        doNotOptimize(allowed);
+    });
+    timePerAccount("dispatch_can_withdraw", "type_tag", [&](){
+        size_t allowed = 0;
+        for(const auto& acc : tagged){
+            allowed += acc->canWithdrawLocked(amount);
+        }
+        doNotOptimize(allowed);
+    });
+}
@@ -0,0 +1,72 @@
+#include "Bench.hpp"
+#include "JsonFields.hpp"
+
+// validateJsonField on an already parsed request, per field type, for good
+// values and for the malformed ones that build an error reply.
+
+namespace {
+    constexpr size_t CALLS = 1000000;
+
+    template <typename Fn>
+    void timeField(const std::string& field, Fn&& fn){
+        auto start = BenchClock::now();
+        for(size_t i = 0; i < CALLS; ++i){
+            fn();
+        }
+        reportResult("fields", "field=" + field, elapsedNs(start) / CALLS, "ns/call");
+    }
+}
+
+void runFieldsBench(){
+    const json request = {
+        {"accountNumber", "1234567"},
+        {"amount", "1234.56"},
+        {"interestRate", "0.035"},
+        {"holderName", "Alice Example"},
+        {"badNumber", "12a45"},
+        {"badAmount", "1.234"}
+    };
+
+    timeField("int", [&request](){
+        json msg;
+        int out = 0;
+        doNotOptimize(validateJsonField(request, "accountNumber", msg, out));
+        doNotOptimize(out);
+    });
+    timeField("money", [&request](){
+        json msg;
+        Money out = 0;
+        doNotOptimize(validateJsonField(request, "amount", msg, out));
+        doNotOptimize(out);
+    });
+    timeField("rate", [&request](){
+        json msg;
+        Rate out = 0;
+        doNotOptimize(validateRateField(request, "interestRate", msg, out));
+        doNotOptimize(out);
+    });
+    timeField("string", [&request](){
+        json msg;
+        std::string out;
+        doNotOptimize(validateJsonField(request, "holderName", msg, out));
+        doNotOptimize(out);
+    });
+    timeField("missing", [&request](){
+        json msg;
+        int out = 0;
+        doNotOptimize(validateJsonField(request, "accountNumber2", msg, out));
+        doNotOptimize(msg);
+    });
+    timeField("bad_int", [&request](){
+        json msg;
+        int out = 0;
+        doNotOptimize(validateJsonField(request, "badNumber", msg, out));
+        doNotOptimize(msg);
+    });
+    timeField("bad_money", [&request](){
+        json msg;
+        Money out = 0;
+        doNotOptimize(validateJsonField(request, "badAmount", msg, out));
+        doNotOptimize(msg);
+    });
+}
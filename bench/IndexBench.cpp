@@ -0,0 +1,54 @@
+#include "Bench.hpp"
+#include "AccountIndex.hpp"
+#include <vector>
+
+namespace {
+    constexpr size_t LOOKUPS = 2000000;
+
+    // The pre-index Bank::findAccount: a linear scan over account numbers
+    size_t linearFind(const std::vector<int>& numbers, int accNum){
+        for(size_t i = 0; i < numbers.size(); ++i){
+            if(numbers[i] == accNum){
+                return i;
+            }
+        }
+        return AccountIndex::npos;
+    }
+}
+
+void runIndexBench(){
+    const size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000};
+
+    for(size_t n : sizes){
+        std::vector<int> numbers(n);
+        AccountIndex index;
+        index.reserve(n);
+        for(size_t i = 0; i < n; ++i){
+            numbers[i] = static_cast<int>(100 + i);
+            index.insert(numbers[i], i);
+        }
+
+        uint64_t rng = 0x9E3779B97F4A7C15ULL;
+        size_t hits = 0;
+        auto start = BenchClock::now();
+        for(size_t i = 0; i < LOOKUPS; ++i){
+            int accNum = numbers[nextRandom(rng) % n];
+            hits += index.find(accNum) != AccountIndex::npos;
+        }
+        doNotOptimize(hits);
+        reportResult("index_lookup", "accounts=" + std::to_string(n), elapsedNs(start) / LOOKUPS, "ns/op");
+
+        // The linear scan is only tractable at small sizes
+        if(n <= 10000){
+            size_t scans = LOOKUPS / 100;
+            hits = 0;
+            start = BenchClock::now();
+            for(size_t i = 0; i < scans; ++i){
+                int accNum = numbers[nextRandom(rng) % n];
+                hits += linearFind(numbers, accNum) != AccountIndex::npos;
+            }
+            doNotOptimize(hits);
+            reportResult("linear_lookup", "accounts=" + std::to_string(n), elapsedNs(start) / scans, "ns/op");
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#include "Bench.hpp"
+#include "InterestEngine.hpp"
+#include <thread>
+
+namespace {
+    constexpr int ACCOUNTS = 1000000;
+}
+
+void runInterestBench(){
+    AccountRegistry registry;
+    registry.reserve(ACCOUNTS);
+    for(int i = 0; i < ACCOUNTS; ++i){
+        registry.insert(std::make_shared<SavingsAccount>(i, "bench", money::fromUnits(1000), 100));
+    }
+
+    // Pre-engine path: per-account lock and a formatted (discarded) message
+    // from applyInterest
+    auto start = BenchClock::now();
+    registry.forEach([](const std::shared_ptr<Account>& acc){
+        if(acc->getType() == AccountType::SAVINGS){
+            static_cast<SavingsAccount&>(*acc).applyInterest();
+        }
+    });
+    reportResult("interest_per_account", "accounts=" + std::to_string(ACCOUNTS), ACCOUNTS / (elapsedNs(start) / 1e9), "accounts/s");
+
+    const size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for(size_t threads = 1; threads <= maxThreads; threads *= 2){
+        InterestEngine::Result result = InterestEngine::applyAll(registry, threads);
+        reportResult("interest_engine", "threads=" + std::to_string(threads), result.accounts / result.seconds, "accounts/s");
+    }
+
+    // The kernel alone, on flat arrays
+    std::vector<Money> balances(ACCOUNTS, money::fromUnits(1000));
+    std::vector<Rate> rates(ACCOUNTS, 100);
+    start = BenchClock::now();
+    InterestEngine::applyKernel(balances.data(), rates.data(), balances.size());
+    doNotOptimize(balances[ACCOUNTS / 2]);
+    reportResult("interest_kernel", "accounts=" + std::to_string(ACCOUNTS), ACCOUNTS / (elapsedNs(start) / 1e9), "accounts/s");
+}
@@ -0,0 +1,54 @@
+#include "Bench.hpp"
+#include "Journal.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr size_t COMMITS_PER_THREAD = 2000;
+
+    // Concurrent requests each journal one account image and wait for its
+    // commit, as Bank::persist does
+    void runPolicy(const std::string& name, FsyncPolicy policy){
+        JournalConfig config;
+        config.path = (std::filesystem::temp_directory_path() / "bank_bench.journal").string();
+        config.policy = policy;
+        config.checkpointBytes = SIZE_MAX;
+
+        for(int threads = 1; threads <= 64; threads *= 4){
+            std::remove(config.path.c_str());
+            Journal& journal = Journal::getInstance();
+            journal.open(config);
+
+            std::vector<std::thread> workers;
+            auto start = BenchClock::now();
+            for(int t = 0; t < threads; ++t){
+                workers.emplace_back([&journal, t](){
+                    AccountImage image{AccountType::CHECKING, t, "bench", 0, 0};
+                    for(size_t i = 0; i < COMMITS_PER_THREAD; ++i){
+                        image.balance = static_cast<Money>(i);
+                        journal.commit(journal.appendSave(image));
+                    }
+                });
+            }
+            for(auto& w : workers){
+                w.join();
+            }
+            double seconds = elapsedNs(start) / 1e9;
+
+            json stats = journal.stats();
+            std::string param = "threads=" + std::to_string(threads);
+            reportResult(name, param, threads * COMMITS_PER_THREAD / seconds, "commits/s");
+            reportResult(name + "_group_size", param, stats["avgEntriesPerSync"].get<double>(), "entries/fsync");
+        }
+
+        Journal::getInstance().open(JournalConfig{config.path, FsyncPolicy::NONE});
+        std::remove(config.path.c_str());
+    }
+}
+
+void runJournalBench(){
+    runPolicy("journal_fsync_per_op", FsyncPolicy::ALWAYS);
+    runPolicy("journal_group_commit", FsyncPolicy::GROUP);
+}
@@ -0,0 +1,140 @@
+#include "Bench.hpp"
+#include "Network.hpp"
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+// Framed send/receive over loopback TCP: a client using sendMessage and
+// recieveMessage against an echo thread that reads with FrameReader and
+// answers with appendFrame/sendAll, as the server does. Measures blocking
+// round trips and pipelined streams at several payload sizes.
+
+namespace {
+    constexpr size_t PIPELINE_DEPTH = 32;
+    const size_t PAYLOAD_SIZES[] = {64, 1024, 16 * 1024, 256 * 1024};
+
+    // Listens on an ephemeral loopback port; returns the socket and sets port
+    int listenLoopback(uint16_t& port){
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if(sock == -1){
+            return -1;
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = 0;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if(bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1 || listen(sock, 1) == -1 ||
+           getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &length) == -1){
+            close(sock);
+            return -1;
+        }
+        port = ntohs(addr.sin_port);
+        return sock;
+    }
+
+    int connectLoopback(uint16_t port){
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if(sock == -1 || connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1){
+            if(sock != -1){
+                close(sock);
+            }
+            return -1;
+        }
+        return sock;
+    }
+
+    void echo(int listener){
+        int sock = accept(listener, nullptr, nullptr);
+        if(sock == -1){
+            return;
+        }
+        FrameReader reader;
+        std::string out;
+        while(reader.readFrom(sock) > 0){
+            std::string_view frame;
+            while(reader.nextFrame(frame)){
+                appendFrame(out, frame);
+            }
+            if(!out.empty()){
+                if(!sendAll(sock, out.data(), out.size())){
+                    break;
+                }
+                out.clear();
+            }
+        }
+        close(sock);
+    }
+
+    void report(const std::string& mode, size_t size, size_t messages, double ns){
+        std::string param = "mode=" + mode + ";bytes=" + std::to_string(size);
+        double seconds = ns / 1e9;
+        reportResult("network_rate", param, messages / seconds, "msgs/s");
+        reportResult("network_throughput", param, 2.0 * messages * size / seconds / (1 << 20), "MiB/s");
+    }
+}
+
+void runNetworkBench(){
+    uint16_t port = 0;
+    int listener = listenLoopback(port);
+    if(listener == -1){
+        std::cerr << "network bench: cannot listen on loopback\n";
+        return;
+    }
+    std::thread server(echo, listener);
+    int sock = connectLoopback(port);
+    if(sock == -1){
+        std::cerr << "network bench: cannot connect over loopback\n";
+        shutdown(listener, SHUT_RDWR);
+        server.join();
+        close(listener);
+        return;
+    }
+    int noDelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    for(size_t size : PAYLOAD_SIZES){
+        const std::string payload(size, 'x');
+        // about the same number of bytes per size, within sane counts
+        size_t messages = std::max<size_t>(500, std::min<size_t>(20000, (64u << 20) / size));
+
+        auto start = BenchClock::now();
+        for(size_t i = 0; i < messages; ++i){
+            sendMessage(sock, payload);
+            if(recieveMessage(sock).size() != size){
+                std::cerr << "network bench: short echo\n";
+                break;
+            }
+        }
+        report("round_trip", size, messages, elapsedNs(start));
+
+        // a writer thread keeps bursts of frames in flight while this
+        // thread reads the echoes, so neither side stalls on a full buffer
+        std::string burst;
+        for(size_t i = 0; i < PIPELINE_DEPTH; ++i){
+            appendFrame(burst, payload);
+        }
+        size_t bursts = std::max<size_t>(1, messages / PIPELINE_DEPTH);
+        start = BenchClock::now();
+        std::thread writer([sock, &burst, bursts](){
+            for(size_t b = 0; b < bursts; ++b){
+                sendAll(sock, burst.data(), burst.size());
+            }
+        });
+        for(size_t i = 0; i < bursts * PIPELINE_DEPTH; ++i){
+            recieveMessage(sock);
+        }
+        writer.join();
+        report("pipelined", size, bursts * PIPELINE_DEPTH, elapsedNs(start));
+    }
+
+    close(sock);
+    server.join();
+    close(listener);
+}
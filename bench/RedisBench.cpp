@@ -0,0 +1,191 @@
+#include "Bench.hpp"
+#include "RedisCache.hpp"
+#include <csignal>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <future>
+#include <thread>
+#include <vector>
+
+extern char** environ;
+
+// RedisCache calls against a private redis-server that the benchmark spawns
+// (--redis-server, --redis-port) with persistence off, so results do not
+// depend on whatever else a local Redis holds and no real data is touched.
+
+namespace {
+    constexpr int ACCOUNTS = 10000;
+    constexpr size_t BATCH = 1000;
+    constexpr size_t POOL_SIZES[] = {1, 2, 4, 8};
+    constexpr int LOAD_THREADS = 8;
+    constexpr size_t ASYNC_BATCH = 250;
+
+    bool acceptsConnections(int port){
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool ok = sock != -1 && connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        if(sock != -1){
+            close(sock);
+        }
+        return ok;
+    }
+
+    // Starts redis-server in the background; returns its pid or -1
+    pid_t spawnRedis(const std::string& binary, int port){
+        if(acceptsConnections(port)){
+            std::cerr << "redis bench: port " << port << " is already in use\n";
+            return -1;
+        }
+
+        std::string portText = std::to_string(port);
+        std::vector<char*> args = {
+            const_cast<char*>(binary.c_str()),
+            const_cast<char*>("--port"), portText.data(),
+            const_cast<char*>("--bind"), const_cast<char*>("127.0.0.1"),
+            const_cast<char*>("--save"), const_cast<char*>(""),
+            const_cast<char*>("--appendonly"), const_cast<char*>("no"),
+            const_cast<char*>("--loglevel"), const_cast<char*>("warning"),
+            nullptr
+        };
+        pid_t pid;
+        if(posix_spawnp(&pid, binary.c_str(), nullptr, nullptr, args.data(), environ) != 0){
+            std::cerr << "redis bench: cannot run " << binary << "\n";
+            return -1;
+        }
+
+        for(int i = 0; i < 500; ++i){
+            if(acceptsConnections(port)){
+                return pid;
+            }
+            if(waitpid(pid, nullptr, WNOHANG) == pid){
+                std::cerr << "redis bench: " << binary << " exited during startup\n";
+                return -1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::cerr << "redis bench: " << binary << " did not start listening on port " << port << "\n";
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        return -1;
+    }
+
+    template <typename Fn>
+    void timeCalls(const std::string& op, const std::string& param, size_t items, const std::string& unit, Fn&& fn){
+        auto start = BenchClock::now();
+        fn();
+        double seconds = elapsedNs(start) / 1e9;
+        reportResult("redis_" + op, param, items / seconds, unit);
+    }
+
+    // LOAD_THREADS request threads loading at once, and a write-behind
+    // sized flush split into async batches, through a cache with each pool size
+    void timePoolSizes(int port, const std::vector<std::shared_ptr<Account>>& accounts){
+        for(size_t poolSize : POOL_SIZES){
+            RedisConfig config{"127.0.0.1", port};
+            config.poolSize = poolSize;
+            RedisCache pooled(config);
+            std::string param = "accounts=" + std::to_string(ACCOUNTS) + ",pool=" + std::to_string(poolSize);
+
+            timeCalls("pool_load", param + ",threads=" + std::to_string(LOAD_THREADS), ACCOUNTS, "accounts/s", [&](){
+                std::vector<std::thread> threads;
+                for(int t = 0; t < LOAD_THREADS; ++t){
+                    threads.emplace_back([&pooled, t](){
+                        for(int i = 1 + t; i <= ACCOUNTS; i += LOAD_THREADS){
+                            doNotOptimize(pooled.loadAccount(i));
+                        }
+                    });
+                }
+                for(auto& thread : threads){
+                    thread.join();
+                }
+            });
+
+            timeCalls("pool_write_async", param + ",batch=" + std::to_string(ASYNC_BATCH), ACCOUNTS, "accounts/s", [&](){
+                std::vector<std::future<bool>> writes;
+                for(size_t begin = 0; begin < accounts.size(); begin += ASYNC_BATCH){
+                    std::vector<std::shared_ptr<Account>> batch(accounts.begin() + begin,
+                                                                accounts.begin() + std::min(accounts.size(), begin + ASYNC_BATCH));
+                    writes.push_back(pooled.writeBatchAsync({}, std::move(batch)));
+                }
+                for(auto& write : writes){
+                    write.wait();
+                }
+            });
+        }
+    }
+}
+
+void runRedisBench(){
+    const BenchOptions& options = benchOptions();
+    pid_t pid = spawnRedis(options.redisServer, options.redisPort);
+    if(pid == -1){
+        return;
+    }
+
+    std::vector<std::shared_ptr<Account>> accounts;
+    accounts.reserve(ACCOUNTS);
+    for(int i = 1; i <= ACCOUNTS; ++i){
+        if(i % 2 == 0){
+            accounts.push_back(std::make_shared<SavingsAccount>(i, "Holder " + std::to_string(i), money::fromUnits(i), 35000));
+        }else{
+            accounts.push_back(std::make_shared<CheckingAccount>(i, "Holder " + std::to_string(i), money::fromUnits(i), 500));
+        }
+    }
+
+    RedisCache& cache = RedisCache::getInstance();
+    const std::string param = "accounts=" + std::to_string(ACCOUNTS);
+    try{
+        timeCalls("save", param, ACCOUNTS, "accounts/s", [&](){
+            for(const auto& acc : accounts){
+                cache.saveAccount(*acc);
+            }
+        });
+
+        timeCalls("load", param, ACCOUNTS, "accounts/s", [&](){
+            for(int i = 1; i <= ACCOUNTS; ++i){
+                doNotOptimize(cache.loadAccount(i));
+            }
+        });
+
+        timeCalls("write_batch", param, ACCOUNTS, "accounts/s", [&](){
+            for(size_t begin = 0; begin < accounts.size(); begin += BATCH){
+                std::vector<std::shared_ptr<Account>> batch(accounts.begin() + begin,
+                                                            accounts.begin() + std::min(accounts.size(), begin + BATCH));
+                cache.writeBatch({}, batch);
+            }
+        });
+
+        std::vector<int> accNums;
+        timeCalls("scan", param, ACCOUNTS, "accounts/s", [&](){
+            accNums = cache.getAllAccountNumbers();
+        });
+
+        timeCalls("load_pipelined", param, ACCOUNTS, "accounts/s", [&](){
+            auto pipe = cache.newPipeline();
+            std::vector<std::unique_ptr<Account>> loaded;
+            for(size_t begin = 0; begin < accNums.size(); begin += BATCH){
+                std::vector<int> batch(accNums.begin() + begin, accNums.begin() + std::min(accNums.size(), begin + BATCH));
+                cache.loadAccounts(pipe, batch, loaded);
+            }
+            doNotOptimize(loaded.size());
+        });
+
+        timePoolSizes(options.redisPort, accounts);
+
+        timeCalls("delete", param, ACCOUNTS, "accounts/s", [&](){
+            for(int i = 1; i <= ACCOUNTS; ++i){
+                cache.deleteAccount(i);
+            }
+        });
+    }catch(const sw::redis::Error& err){
+        std::cerr << "redis bench: " << err.what() << "\n";
+    }
+
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+}
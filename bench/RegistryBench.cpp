@@ -0,0 +1,85 @@
+#include "Bench.hpp"
+#include "AccountRegistry.hpp"
+#include "CheckingAccount.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int ACCOUNTS = 1000000;
+    constexpr size_t OPS_PER_THREAD = 250000;
+
+    // Request mix seen by the server: mostly lookups, some creates and closes
+    template <typename Registry>
+    void clientLoop(Registry& registry, int threadId, std::atomic<size_t>& hits){
+        uint64_t rng = 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(threadId + 1) * 0xBF58476D1CE4E5B9ULL;
+        size_t found = 0;
+        for(size_t i = 0; i < OPS_PER_THREAD; ++i){
+            uint64_t r = nextRandom(rng);
+            int accNum = static_cast<int>(r % (ACCOUNTS * 2));
+            switch(r >> 60){
+                case 0:
+                    registry.insert(std::make_shared<CheckingAccount>(accNum, "bench", 0, 0));
+                    break;
+                case 1:
+                    registry.erase(accNum);
+                    break;
+                default:
+                    found += registry.find(accNum) != nullptr;
+            }
+        }
+        hits += found;
+    }
+
+    // Baseline: the same table behind one global lock
+    struct GlobalLockRegistry{
+        std::mutex mtx;
+        AccountRegistry registry;
+
+        std::shared_ptr<Account> find(int accNum){
+            std::lock_guard<std::mutex> lock(mtx);
+            return registry.find(accNum);
+        }
+        bool insert(std::shared_ptr<Account> acc){
+            std::lock_guard<std::mutex> lock(mtx);
+            return registry.insert(std::move(acc));
+        }
+        std::shared_ptr<Account> erase(int accNum){
+            std::lock_guard<std::mutex> lock(mtx);
+            return registry.erase(accNum);
+        }
+    };
+
+    template <typename Registry>
+    void runScaling(const std::string& name, Registry& registry){
+        for(int threads = 1; threads <= 64; threads *= 2){
+            std::atomic<size_t> hits{0};
+            std::vector<std::thread> workers;
+            auto start = BenchClock::now();
+            for(int t = 0; t < threads; ++t){
+                workers.emplace_back([&registry, t, &hits]{ clientLoop(registry, t, hits); });
+            }
+            for(auto& w : workers){
+                w.join();
+            }
+            double seconds = elapsedNs(start) / 1e9;
+            doNotOptimize(hits.load());
+            reportResult(name, "threads=" + std::to_string(threads), threads * OPS_PER_THREAD / seconds / 1e6, "Mops/s");
+        }
+    }
+}
+
+void runRegistryBench(){
+    AccountRegistry striped;
+    striped.reserve(ACCOUNTS * 2);
+    GlobalLockRegistry global;
+    global.registry.reserve(ACCOUNTS * 2);
+    for(int i = 0; i < ACCOUNTS; ++i){
+        striped.insert(std::make_shared<CheckingAccount>(i * 2, "bench", 0, 0));
+        global.registry.insert(std::make_shared<CheckingAccount>(i * 2, "bench", 0, 0));
+    }
+
+    runScaling("registry_striped", striped);
+    runScaling("registry_global_lock", global);
+}
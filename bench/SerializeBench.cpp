@@ -0,0 +1,63 @@
+#include "Bench.hpp"
+#include "SavingsAccount.hpp"
+#include "CheckingAccount.hpp"
+#include "BinaryProtocol.hpp"
+#include <memory>
+#include <vector>
+
+// Cost per account of the account representations the server sends: the
+// toJson object (DISPLAY_ALL, export), its dump() text, the display() reply
+// of DISPLAY_ONE, and the binary DISPLAY_ALL record.
+
+namespace {
+    constexpr int ACCOUNTS = 100000;
+
+    template <typename Fn>
+    void timeAccounts(const std::string& format, const std::vector<std::shared_ptr<Account>>& accounts, Fn&& fn){
+        size_t bytes = 0;
+        auto start = BenchClock::now();
+        for(const auto& acc : accounts){
+            bytes += fn(*acc);
+        }
+        double ns = elapsedNs(start);
+        doNotOptimize(bytes);
+        reportResult("serialize", "format=" + format, ns / accounts.size(), "ns/account");
+    }
+}
+
+void runSerializeBench(){
+    std::vector<std::shared_ptr<Account>> accounts;
+    accounts.reserve(ACCOUNTS);
+    for(int i = 0; i < ACCOUNTS; ++i){
+        if(i % 2 == 0){
+            accounts.push_back(std::make_shared<SavingsAccount>(i, "Holder " + std::to_string(i), money::fromUnits(i) + 55, 35000));
+        }else{
+            accounts.push_back(std::make_shared<CheckingAccount>(i, "Holder " + std::to_string(i), money::fromUnits(i) + 55, 500));
+        }
+    }
+
+    timeAccounts("to_json", accounts, [](const Account& acc){
+        return acc.toJson().size();
+    });
+    timeAccounts("to_json_dump", accounts, [](const Account& acc){
+        return acc.toJson().dump().size();
+    });
+    timeAccounts("display_dump", accounts, [](const Account& acc){
+        return acc.display().dump().size();
+    });
+
+    std::vector<BinaryAccount> list(1);
+    std::string out;
+    timeAccounts("binary", accounts, [&list, &out](const Account& acc){
+        AccountImage image;
+        {
+            std::unique_lock<std::mutex> lock = acc.lock();
+            acc.imageLocked(image);
+        }
+        list[0] = BinaryAccount{static_cast<AccountKind>(image.type), image.accountNumber, image.balance,
+                                image.rateOrLimit, std::move(image.holderName)};
+        out.clear();
+        encodeAccountList(list, 0, out);
+        return out.size();
+    });
+}
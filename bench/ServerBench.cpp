@@ -0,0 +1,89 @@
+#include "Bench.hpp"
+#include "Network.hpp"
+#include <algorithm>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+
+// Measures request latency against a running bank_server while it holds a
+// growing number of idle connections. Run once per server mode
+// (bank_server --mode threads / --mode epoll) to compare them.
+
+namespace {
+    constexpr size_t REQUESTS = 20000;
+
+    int connectToServer(){
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if(sock == -1){
+            return -1;
+        }
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(PORT);
+        inet_pton(AF_INET, SERVER_IP, &addr.sin_addr);
+        if(connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1){
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+
+    void raiseFdLimit(){
+        rlimit limit{};
+        if(getrlimit(RLIMIT_NOFILE, &limit) == 0){
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+void runServerBench(){
+    raiseFdLimit();
+
+    int active = connectToServer();
+    if(active == -1){
+        std::cerr << "server bench: bank_server is not running on " << SERVER_IP << ":" << PORT << "\n";
+        return;
+    }
+
+    const std::string request = R"({"action":"DISPLAY_ONE","accountNumber":"101"})";
+    std::vector<int> idle;
+    const size_t idleCounts[] = {0, 100, 1000, 5000};
+
+    for(size_t target : idleCounts){
+        while(idle.size() < target){
+            int sock = connectToServer();
+            if(sock == -1){
+                break;
+            }
+            idle.push_back(sock);
+        }
+
+        std::vector<double> latencies;
+        latencies.reserve(REQUESTS);
+        for(size_t i = 0; i < REQUESTS; ++i){
+            auto start = BenchClock::now();
+            sendMessage(active, request);
+            if(recieveMessage(active).empty()){
+                std::cerr << "server bench: connection closed\n";
+                break;
+            }
+            latencies.push_back(elapsedNs(start) / 1000.0);
+        }
+        if(latencies.empty()){
+            break;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::string param = "idle=" + std::to_string(idle.size());
+        reportResult("server_p50", param, latencies[latencies.size() / 2], "us");
+        reportResult("server_p99", param, latencies[latencies.size() * 99 / 100], "us");
+    }
+
+    for(int sock : idle){
+        close(sock);
+    }
+    close(active);
+}
@@ -0,0 +1,46 @@
+#include "Bench.hpp"
+#include "Snapshot.hpp"
+#include "SavingsAccount.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+// Restart path: write the table to a snapshot, then map it and rebuild the
+// table from it, as a server boot does before falling back to Redis
+void runSnapshotBench(){
+    const std::string path = (std::filesystem::temp_directory_path() / "bank_bench.snapshot").string();
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int count : {1000000, 10000000}){
+        std::string param = "accounts=" + std::to_string(count);
+        {
+            auto registry = std::make_unique<AccountRegistry>();
+            registry->reserve(count);
+            for(int i = 0; i < count; ++i){
+                registry->insert(std::make_shared<SavingsAccount>(i, "holder" + std::to_string(i % 1000), i, 100));
+            }
+
+            auto start = BenchClock::now();
+            Snapshot::write(path, *registry, 0);
+            reportResult("snapshot_write", param, elapsedNs(start) / 1e9, "s");
+        }
+
+        auto registry = std::make_unique<AccountRegistry>();
+        auto start = BenchClock::now();
+        Snapshot snapshot;
+        if(!snapshot.open(path)){
+            std::cerr << "snapshot bench: cannot open " << path << "\n";
+            return;
+        }
+        double mapSeconds = elapsedNs(start) / 1e9;
+        snapshot.loadInto(*registry, threads);
+        double seconds = elapsedNs(start) / 1e9;
+
+        reportResult("snapshot_map_verify", param, mapSeconds, "s");
+        reportResult("snapshot_restart", param, seconds, "s");
+        reportResult("snapshot_restart_rate", param, count / seconds, "accounts/s");
+        doNotOptimize(registry->size());
+    }
+    std::remove(path.c_str());
+}
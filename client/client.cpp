@@ -1,9 +1,12 @@
 #include "../include/Network.hpp"
+#include "../include/BinaryProtocol.hpp"
 #include <arpa/inet.h>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
+#include <map>
+#include <stdexcept>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -48,17 +51,18 @@ void displayResponse(const json& response) {
                 std::string type = acc.value("accountType", "UNKNOWN");
                 int number = acc.value("accountNumber", 0);
                 std::string holder = acc.value("holderName", "N/A");
-                double balance = acc.value("balance", 0.0);
+                std::string balance = acc.value("balance", "0.00"); // exact decimal text
 
-                // Format rate/limit with 2 decimal places
                 std::ostringstream rateLimitStream;
-                rateLimitStream << std::fixed << std::setprecision(2);
                 
                 if (type == "SAVINGS") {
-                    double rate = acc.value("interestRate", 0.0);
-                    rateLimitStream << (rate * 100) << "%";
+                    // millionths of 1 are ten-thousandths of a percent
+                    Rate rate = 0;
+                    money::parseRate(acc.value("interestRate", "0"), rate);
+                    char buf[money::MAX_CHARS];
+                    rateLimitStream << std::string(buf, money::formatFixed(rate, money::RATE_DIGITS - 2, buf, true)) << "%";
                 } else if (type == "CHECKING") {
-                    double limit = acc.value("overdraftLimit", 0.0);
+                    int limit = acc.value("overdraftLimit", 0);
                     rateLimitStream << "$" << limit;
                 } else {
                     rateLimitStream << "N/A";
@@ -68,7 +72,7 @@ void displayResponse(const json& response) {
                           << std::setw(10) << type
                           << std::setw(10) << number
                           << std::setw(25) << holder
-                          << std::setw(15) << std::fixed << std::setprecision(2) << balance
+                          << std::setw(15) << balance
                           << std::setw(15) << rateLimitStream.str()
                           << "\n";
 
@@ -84,7 +88,104 @@ void displayResponse(const json& response) {
     }
 }
 
-int main(){
+// Encodes a CLI request in the negotiated protocol. Throws std::exception
+// on arguments that are not valid numbers in binary mode.
+std::string toWire(const json& request, bool binary){
+    if(!binary){
+        return request.dump();
+    }
+
+    static const std::map<std::string, Opcode> opcodes = {
+        {"CREATE", Opcode::CREATE}, {"DELETE", Opcode::DELETE}, {"MODIFY", Opcode::MODIFY},
+        {"DEPOSIT", Opcode::DEPOSIT}, {"WITHDRAW", Opcode::WITHDRAW}, {"TRANSFER", Opcode::TRANSFER},
+        {"APPLY_INTEREST_ONE", Opcode::APPLY_INTEREST_ONE}, {"APPLY_INTEREST_ALL", Opcode::APPLY_INTEREST_ALL},
+        {"DISPLAY_ONE", Opcode::DISPLAY_ONE}, {"DISPLAY_ALL", Opcode::DISPLAY_ALL},
+        {"DELETE_ALL", Opcode::DELETE_ALL}, {"EXPORT_JSON", Opcode::EXPORT_JSON}, {"EXIT", Opcode::EXIT}
+    };
+
+    auto opcode = opcodes.find(request.at("action").get<std::string>());
+    if(opcode == opcodes.end()){
+        throw std::invalid_argument(request.at("action").get<std::string>() + " needs the JSON protocol");
+    }
+
+    BinaryRequest req;
+    req.op = opcode->second;
+
+    auto fixed = [&request](const char* key, int digits){
+        int64_t value;
+        if(!money::parseFixed(request.value(key, std::string("0")), digits, value)){
+            throw std::invalid_argument(std::string("invalid ") + key);
+        }
+        return value;
+    };
+    req.accountNumber = static_cast<int32_t>(std::stol(request.value("accountNumber", request.value("accountNumber1", std::string("0")))));
+    req.accountNumber2 = static_cast<int32_t>(std::stol(request.value("accountNumber2", std::string("0"))));
+    req.amount = fixed("amount", money::CENT_DIGITS);
+    req.balance = fixed("balance", money::CENT_DIGITS);
+    req.rateOrLimit = request.contains("interestRate") ? fixed("interestRate", money::RATE_DIGITS) : fixed("overdraftLimit", 0);
+    req.accountType = request.value("accountType", std::string()) == "CHECKING" ? AccountKind::CHECKING : AccountKind::SAVINGS;
+    if(req.op == Opcode::DISPLAY_ALL){
+        req.accountType = request.contains("accountType") ? req.accountType : AccountKind::ANY;
+        if(request.contains("cursor") && !request["cursor"].is_null() &&
+           !parseCursor(request["cursor"].get_ref<const std::string&>(), req.cursor)){
+            throw std::invalid_argument("invalid cursor");
+        }
+        req.limit = static_cast<uint32_t>(std::stoul(request.value("limit", std::string("0"))));
+    }
+
+    std::string holderName = request.value("holderName", std::string());
+    req.holderName = holderName;
+
+    std::string out;
+    encodeRequest(req, out);
+    return out;
+}
+
+// Decodes a response into the JSON shape displayResponse expects
+json fromWire(const std::string& payload, const json& request, bool binary){
+    if(!binary){
+        return json::parse(payload);
+    }
+
+    json response;
+    if(request.at("action") == "DISPLAY_ALL"){
+        std::vector<BinaryAccount> list;
+        uint64_t nextCursor;
+        if(!decodeAccountList(payload, list, nextCursor)){
+            throw std::runtime_error("malformed account list");
+        }
+        response["nextCursor"] = nextCursor ? json(cursorToString(nextCursor)) : json(nullptr);
+        response["accounts"] = json::array();
+        for(const auto& acc : list){
+            bool savings = acc.accountType == AccountKind::SAVINGS;
+            json accData = {
+                {"accountType", savings ? "SAVINGS" : "CHECKING"},
+                {"accountNumber", acc.accountNumber},
+                {"holderName", acc.holderName},
+                {"balance", money::toString(acc.balance)}
+            };
+            if(savings){
+                accData["interestRate"] = money::rateToString(acc.rateOrLimit);
+            }else{
+                accData["overdraftLimit"] = acc.rateOrLimit;
+            }
+            response["accounts"].push_back(accData);
+        }
+        return response;
+    }
+
+    bool success;
+    std::string_view message;
+    if(!decodeResponse(payload, success, message)){
+        throw std::runtime_error("empty response");
+    }
+    response["status"] = success ? "success: " : "failed: ";
+    response["message"] = std::string(message);
+    return response;
+}
+
+int main(int argc, char* argv[]){
+    bool binary = argc > 1 && std::string(argv[1]) == "--binary";
     struct sockaddr_in server_addr;
     int sock = socket(AF_INET, SOCK_STREAM, 0);
 
@@ -107,6 +208,18 @@ int main(){
         exit(EXIT_FAILURE);
     }
 
+    if(binary){
+        // negotiate the binary protocol; everything after this frame is binary
+        json hello = { {"action", "HELLO"}, {"protocol", "binary"} };
+        sendMessage(sock, hello.dump());
+        try{
+            displayResponse(json::parse(recieveMessage(sock)));
+        }catch(const json::exception& e){
+            std::cerr << "Protocol negotiation failed: " << e.what() << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
     std::vector<json> testCommands = {
     { {"action", "CREATE"}, {"accountType", "SAVINGS"}, {"accountNumber", "101"}, {"holderName", "Alice"}, {"balance", "1000"}, {"interestRate", "0.03"} },
     { {"action", "CREATE"}, {"accountType", "CHECKING"}, {"accountNumber", "102"}, {"holderName", "Bob"}, {"balance", "500"}, {"overdraftLimit", "200"} },
@@ -125,195 +238,234 @@ int main(){
     { {"action", "EXIT"} } */   // EXIT works
     };
 
-    size_t testIndex = 0;
     char test_yes_no;
     std::cout << "Would you like to run a test? (y) or (n): ";
     std::cin >> test_yes_no;
     std::cin.ignore();
 
+    if(test_yes_no == 'y' || test_yes_no == 'Y'){
+        // pipeline the whole test script in one write, then read the
+        // responses back in order
+        std::string frames;
+        for(const auto& command : testCommands){
+            appendFrame(frames, toWire(command, binary));
+        }
+        sendAll(sock, frames.data(), frames.size());
+
+        for(const auto& command : testCommands){
+            try{
+                displayResponse(fromWire(recieveMessage(sock), command, binary));
+            }catch(const std::exception& e){
+                std::cerr << "Invalid server response: " << e.what() << "\n";
+            }
+        }
+    }
+
     while(true){
         json request;
 
-        if(testIndex < testCommands.size() && test_yes_no == 'y' || test_yes_no == 'Y'){
-            request = testCommands[testIndex++];
-        }else{
-            std::string line, action, accountType;
-            std::vector<std::string> items;
-            
-            std::cout << SERVER_IP << ":" << PORT << "> ";
-            std::getline(std::cin, line);
-            std::stringstream ss(line);
-            std::string item;
-
-            while(ss >> item){
-                items.push_back(item);
-            }
+        std::string line, action, accountType;
+        std::vector<std::string> items;
+        
+        std::cout << SERVER_IP << ":" << PORT << "> ";
+        std::getline(std::cin, line);
+        std::stringstream ss(line);
+        std::string item;
 
-            if(items.size() > 6){
-                std::cerr << "Error: Too many arguments passed\n";
-                continue;
-            }
+        while(ss >> item){
+            items.push_back(item);
+        }
 
-            if(items.empty()) {
-                std::cerr << "Error: No command entered\n";
-                continue;
-            }
+        if(items.size() > 6){
+            std::cerr << "Error: Too many arguments passed\n";
+            continue;
+        }
 
-            action = items[0];
-            std::transform(action.begin(), action.end(), action.begin(), ::toupper);
+        if(items.empty()) {
+            std::cerr << "Error: No command entered\n";
+            continue;
+        }
 
-            if(action != "APPLY_INTEREST_ALL" && action != "DISPLAY_ALL" && action != "DELETE_ALL" && action != "EXPORT_JSON" && action != "EXIT") {
-                if(items.size() < 2) {
-                    std::cerr << "Error: Missing required arguments\n";
-                    continue;
-                }
-                std::transform(items[1].begin(), items[1].end(), items[1].begin(), ::toupper);
+        action = items[0];
+        std::transform(action.begin(), action.end(), action.begin(), ::toupper);
+
+        if(action != "APPLY_INTEREST_ALL" && action != "DISPLAY_ALL" && action != "DELETE_ALL" && action != "EXPORT_JSON" && action != "EXPORT_STATUS" && action != "EXIT") {
+            if(items.size() < 2) {
+                std::cerr << "Error: Missing required arguments\n";
+                continue;
             }
+            std::transform(items[1].begin(), items[1].end(), items[1].begin(), ::toupper);
+        }
 
-            if(action == "CREATE" && items.size() == 6){
-                /* 
-                    formatting:
-                    CREATE ACCOUNT_TYPE accountNumber holderName balance rate/limit
-                */
-                request["action"] = action;
-                request["accountType"] = items[1];
-                request["accountNumber"] = items[2];
-                request["holderName"] = items[3];
-                request["balance"] = items[4];
-                if(items[1] == "SAVINGS"){
-                    request["interestRate"] = items[5];
-                }else if(items[1] == "CHECKING"){
-                    request["overdraftLimit"] = items[5];
-                }else{
-                    std::cerr << "Unkown account type\n";
-                    continue;
-                }
-            }else if(action == "DELETE"){
-                /* 
-                    formatting:
-                    DELETE accountNumber
-                */
-                request["action"] = action;
-                request["accountNumber"] = items[1];
-            }else if(action == "MODIFY"){
-                /* 
-                    formatting:
-                    MODIFY accountNumber holderName balance rate/limit
-                */
-                request["action"] = action;
-                request["accountNumber"] = items[1];
-                request["holderName"] = items[2];
-                request["balance"] = items[3];
-
-                if(accountType == "SAVINGS"){
-                    request["interestRate"] = items[4];
-                }else if(accountType == "CHECKING"){
-                    request["overdraft"] = items[4];
-                }else{
-                    std::cerr << "Unkown account type\n";
-                    continue;
-                }
-            }else if(action == "DEPOSIT"){
-                /* 
-                    foramtting:
-                    DEPOSIT accountNumber amount
-                */
+        if(action == "CREATE" && items.size() == 6){
+            /* 
+                formatting:
+                CREATE ACCOUNT_TYPE accountNumber holderName balance rate/limit
+            */
+            request["action"] = action;
+            request["accountType"] = items[1];
+            request["accountNumber"] = items[2];
+            request["holderName"] = items[3];
+            request["balance"] = items[4];
+            if(items[1] == "SAVINGS"){
+                request["interestRate"] = items[5];
+            }else if(items[1] == "CHECKING"){
+                request["overdraftLimit"] = items[5];
+            }else{
+                std::cerr << "Unkown account type\n";
+                continue;
+            }
+        }else if(action == "DELETE"){
+            /* 
+                formatting:
+                DELETE accountNumber
+            */
             request["action"] = action;
             request["accountNumber"] = items[1];
-            request["amount"] = items[2];
-            }else if(action == "WITHDRAW"){
-                /* 
-                    foramtting:
-                    WITHDRAW accountNumber amount
-                */
+        }else if(action == "MODIFY"){
+            /* 
+                formatting:
+                MODIFY accountNumber holderName balance rate/limit
+            */
             request["action"] = action;
             request["accountNumber"] = items[1];
-            request["amount"] = items[2];
-            }else if(action == "TRANSFER"){
-                /* 
-                    formatting:
-                    TRANSFER From_Account# To_Account# amount
-                */
-                request["action"] = action;
-                request["accountNumber1"] = items[1];
-                request["accountNumber2"] = items[2];
-                request["amount"] = items[3];
-            }else if(action == "APPLY_INTEREST_ONE"){
-                /* 
-                    formatting:
-                    APPLY_INTEREST_ONE accountNumber
-                */
-                request["action"] = action;
-                request["accountNumber"] = items[1];
-            }else if(action == "APPLY_INTEREST_ALL"){
-                /* 
-                    formatting:
-                    APPLY_INTEREST_ALL
-                */
-                request["action"] = action;
-            }else if(action == "DISPLAY_ONE"){
-                /* 
-                    formatting:
-                    DISPLAY_ONE accountNumber
-                */
+            request["holderName"] = items[2];
+            request["balance"] = items[3];
+
+            if(accountType == "SAVINGS"){
+                request["interestRate"] = items[4];
+            }else if(accountType == "CHECKING"){
+                request["overdraft"] = items[4];
+            }else{
+                std::cerr << "Unkown account type\n";
+                continue;
+            }
+        }else if(action == "DEPOSIT"){
+            /* 
+                foramtting:
+                DEPOSIT accountNumber amount
+            */
+        request["action"] = action;
+        request["accountNumber"] = items[1];
+        request["amount"] = items[2];
+        }else if(action == "WITHDRAW"){
+            /* 
+                foramtting:
+                WITHDRAW accountNumber amount
+            */
+        request["action"] = action;
+        request["accountNumber"] = items[1];
+        request["amount"] = items[2];
+        }else if(action == "TRANSFER"){
+            /* 
+                formatting:
+                TRANSFER From_Account# To_Account# amount
+            */
+            request["action"] = action;
+            request["accountNumber1"] = items[1];
+            request["accountNumber2"] = items[2];
+            request["amount"] = items[3];
+        }else if(action == "APPLY_INTEREST_ONE"){
+            /* 
+                formatting:
+                APPLY_INTEREST_ONE accountNumber
+            */
             request["action"] = action;
             request["accountNumber"] = items[1];
-            }else if(action == "DISPLAY_ALL"){
-                /* 
-                    formatting:
-                    DISPLAY_ALL
-                */
-                request["action"] = action;
-                sendMessage(sock, request.dump());
-                std::string rawResponse = recieveMessage(sock);
-                
-                if(rawResponse.empty()){
-                    std::cerr << "[ERROR] Empty response from server\n";
-                    continue;
+        }else if(action == "APPLY_INTEREST_ALL"){
+            /* 
+                formatting:
+                APPLY_INTEREST_ALL
+            */
+            request["action"] = action;
+        }else if(action == "DISPLAY_ONE"){
+            /* 
+                formatting:
+                DISPLAY_ONE accountNumber
+            */
+        request["action"] = action;
+        request["accountNumber"] = items[1];
+        }else if(action == "DISPLAY_ALL"){
+            /* 
+                formatting:
+                DISPLAY_ALL [SAVINGS|CHECKING] [pageSize]
+            */
+            request["action"] = action;
+            for(size_t i = 1; i < items.size(); ++i){
+                std::string arg = items[i];
+                std::transform(arg.begin(), arg.end(), arg.begin(), ::toupper);
+                if(arg == "SAVINGS" || arg == "CHECKING"){
+                    request["accountType"] = arg;
+                }else{
+                    request["limit"] = arg;
                 }
-                
-                try{
-                    json response = json::parse(rawResponse);
+            }
+
+            // walk the pages one at a time, so neither side holds the whole table
+            try{
+                do{
+                    sendMessage(sock, toWire(request, binary));
+                    std::string rawResponse = recieveMessage(sock);
+                    if(rawResponse.empty()){
+                        std::cerr << "[ERROR] Empty response from server\n";
+                        break;
+                    }
+
+                    json response = fromWire(rawResponse, request, binary);
                     displayResponse(response);
-                }catch(const json::exception& e) {
-                    std::cerr << "JSON parse error: " << e.what() << "\n";
-                    std::cerr << "Raw response was:\n" << rawResponse << "\n";
-                }
-                continue;  // Skip the duplicate receive at bottom
-            }else if(action == "DELETE_ALL"){
-                /* 
-                    formatting:
-                    DELETE_ALL
-                */
+                    request["cursor"] = response.value("nextCursor", json(nullptr));
+                }while(!request["cursor"].is_null());
+            }catch(const std::exception& e) {
+                std::cerr << "Invalid server response: " << e.what() << "\n";
+            }
+            continue;  // Skip the duplicate receive at bottom
+        }else if(action == "DELETE_ALL"){
+            /* 
+                formatting:
+                DELETE_ALL
+            */
+        request["action"] = action;
+        }else if(action == "EXPORT_JSON"){
+            /* 
+                formatting:
+                EXPORT_JSON [json|ndjson|csv] [path]
+            */
             request["action"] = action;
-            }else if(action == "EXPORT_JSON"){
-                /* 
-                    formatting:
-                    EXPORT_JSON
-                */
-                request["action"] = action;
-            }else if(action == "EXIT"){
-
-                /*
-                    formatting:
-                    EXIT 
-                */
-                request["action"] = action;
-                sendMessage(sock, request.dump());
-
-                break;
-            }else{
-                std::cerr << "Error: Invalid action!\n";
-                continue;
+            if(items.size() > 1){
+                request["format"] = items[1];
             }
-        }
+            if(items.size() > 2){
+                request["path"] = items[2];
+            }
+        }else if(action == "EXPORT_STATUS"){
+            /* 
+                formatting:
+                EXPORT_STATUS [jobId]
+            */
+            request["action"] = action;
+            if(items.size() > 1){
+                request["jobId"] = items[1];
+            }
+        }else if(action == "EXIT"){
 
-        sendMessage(sock, request.dump());
+            /*
+                formatting:
+                EXIT 
+            */
+            request["action"] = action;
+            sendMessage(sock, toWire(request, binary));
+
+            break;
+        }else{
+            std::cerr << "Error: Invalid action!\n";
+            continue;
+        }
 
         try{
-            json response = json::parse(recieveMessage(sock));
+            sendMessage(sock, toWire(request, binary));
+            json response = fromWire(recieveMessage(sock), request, binary);
             displayResponse(response);
-        }catch(const json::exception& e){
+        }catch(const std::exception& e){
             std::cerr << "Invalid server response: " << e.what() << "\n";
         }
     }
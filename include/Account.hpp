@@ -4,31 +4,116 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include "Money.hpp"
 
 using json = nlohmann::json;
 
+// The account hierarchy is closed: every Account is a SavingsAccount or a
+// CheckingAccount, and this tag says which (see visitAccount)
+enum class AccountType : uint8_t{
+    SAVINGS = 1,
+    CHECKING = 2
+};
+
+// Longest holder name a request may set, in bytes: the journal and the
+// binary protocol store it behind a 16-bit length
+constexpr size_t MAX_HOLDER_NAME = UINT16_MAX;
+
+constexpr const char* accountTypeName(AccountType type){
+    return type == AccountType::SAVINGS ? "SAVINGS" : "CHECKING";
+}
+
+inline bool parseAccountType(std::string_view name, AccountType& out){
+    if(name == "SAVINGS"){
+        out = AccountType::SAVINGS;
+    }else if(name == "CHECKING"){
+        out = AccountType::CHECKING;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+// Plain copy of an account's persistent fields, e.g. for the journal
+struct AccountImage{
+    AccountType type = AccountType::SAVINGS;
+    int accountNumber = 0;
+    std::string holderName;
+    Money balance = 0;
+    int64_t rateOrLimit = 0; // interest rate (SAVINGS) or overdraft limit (CHECKING)
+};
+
+// Type-specific operations are not virtual: they switch on the type tag and
+// call the concrete (final) class directly, so there is no RTTI, no string
+// compare and no indirect call on the hot paths.
 class Account{
 public:
-    Account(int accNum, const std::string& name, double initialBalance);
     virtual ~Account();
-    
-    virtual json withdraw(double amount) = 0;
-    virtual json display() const = 0;
-    virtual json toJson() const = 0;
-    virtual std::string getHolderName() const = 0;
-    virtual std::string getAccountType() const = 0;
-
-    json deposit(double amount);
+
+    AccountType getType() const { return type; } // fixed at construction, no lock needed
+
+    json withdraw(Money amount);
+    json display() const;
+    json toJson() const;
+    std::string getHolderName() const;
+
+    json deposit(Money amount);
     int getAccountNumber() const;
-    double getBalance() const;
+    Money getBalance() const;
     void setHolderName(const std::string& name);
-    void setBalance(double newBalance);
+    void setBalance(Money newBalance);
+
+    // Bulk operations lock many accounts at once: take lock() (in ascending
+    // account number order) and use the *Locked accessors while holding it
+    std::unique_lock<std::mutex> lock() const;
+    Money getBalanceLocked() const;
+    void setBalanceLocked(Money newBalance);
+    void setHolderNameLocked(const std::string& name){ holderName = name; }
+    bool canWithdrawLocked(Money amount) const; // funds or overdraft cover amount
+    AccountImage imageLocked() const;
+    void imageLocked(AccountImage& out) const; // reuses out's name buffer
+
+    static std::shared_ptr<Account> fromImage(const AccountImage& image);
+
+    // Set once the account leaves the Bank; pending writes for it are dropped
+    void markClosed();
+    bool isClosed() const;
+
+    // Reference bit for the hot-set cache's CLOCK eviction: set by lookups,
+    // cleared (and read) as the eviction hand passes. Only written when it
+    // changes, so hits on a hot account do not bounce its cache line.
+    void markUsed() const {
+        if(!used.load(std::memory_order_relaxed)){
+            used.store(true, std::memory_order_relaxed);
+        }
+    }
+    bool takeUsed() const { return used.exchange(false, std::memory_order_relaxed); }
+
+    // Dirty tracking against Redis: Bank::persist bumps the version under
+    // the account lock after each change, and a successful Redis write
+    // records the version it wrote (read under the same lock as the data)
+    void markDirtyLocked(){ version.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t versionLocked() const { return version.load(std::memory_order_relaxed); }
+    void markSaved(uint64_t written) const;
+    bool isDirty() const {
+        return savedVersion.load(std::memory_order_relaxed) != version.load(std::memory_order_relaxed);
+    }
 protected:
-    std::mutex mtx;
+    Account(AccountType type, int accNum, const std::string& name, Money initialBalance);
+
+    const AccountType type;
+    mutable std::mutex mtx; // guards every field below; accounts are shared across client threads
     int accountNumber;
     std::string holderName;
-    double balance;
+    Money balance; // cents
+    std::atomic<bool> closed{false};
+    mutable std::atomic<bool> used{false};
+    std::atomic<uint64_t> version{0};
+    mutable std::atomic<uint64_t> savedVersion{0};
 };
\ No newline at end of file
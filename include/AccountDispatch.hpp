@@ -0,0 +1,22 @@
+#pragma once
+
+#include "SavingsAccount.hpp"
+#include "CheckingAccount.hpp"
+#include <type_traits>
+
+// Calls fn with acc as its concrete class, picked by the type tag. Both
+// classes are final, so this is the whole of the "virtual" dispatch: one
+// predictable branch, then every call fn makes binds statically (and can be
+// inlined). A const Account is visited as a const subclass.
+template <typename AccountT, typename Fn>
+decltype(auto) visitAccount(AccountT& acc, Fn&& fn){
+    static_assert(std::is_same_v<std::remove_const_t<AccountT>, Account>, "visit through Account");
+    constexpr bool isConst = std::is_const_v<AccountT>;
+    using Savings = std::conditional_t<isConst, const SavingsAccount, SavingsAccount>;
+    using Checking = std::conditional_t<isConst, const CheckingAccount, CheckingAccount>;
+
+    if(acc.getType() == AccountType::SAVINGS){
+        return fn(static_cast<Savings&>(acc));
+    }
+    return fn(static_cast<Checking&>(acc));
+}
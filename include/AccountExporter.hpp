@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AccountRegistry.hpp"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+enum class ExportFormat{
+    JSON,   // one array, one account object per line
+    NDJSON, // one account object per line, nothing else
+    CSV     // header row, then one row per account (RFC 4180 quoting)
+};
+
+struct ExportConfig{
+    std::string directory = "exports"; // every export path is resolved under it
+    size_t maxRunning = 2; // concurrent jobs; further requests are refused
+};
+
+// Background export of the account table. Each job walks the registry in
+// fixed slot ranges, captures every account under its own lock and streams
+// it through a fixed-size buffer into path.tmp, then renames it over path,
+// so memory use does not grow with the table and readers never see a
+// half-written file. Requests only start a job and return its id; progress
+// is polled with status().
+class AccountExporter{
+public:
+    static AccountExporter& getInstance(){
+        static AccountExporter instance;
+        return instance;
+    }
+
+    void configure(const ExportConfig& config);
+
+    static bool parseFormat(const std::string& name, ExportFormat& out);
+    static const char* formatName(ExportFormat format);
+
+    // Starts an export job on its own thread and returns its id, or 0 with
+    // error set if the path is refused or maxRunning jobs are running.
+    // path is relative to the export directory, without "." or ".." parts,
+    // and must end in .json, .ndjson or .csv; an existing target must be a
+    // regular file, and directories on the way real ones (not symlinks)
+    uint64_t start(const AccountRegistry& registry, ExportFormat format, const std::string& path, std::string& error);
+
+    // Progress of one job (0 = the most recent one); false if unknown
+    bool status(uint64_t id, json& out) const;
+private:
+    struct Job{
+        uint64_t id = 0;
+        ExportFormat format = ExportFormat::JSON;
+        std::string path;
+        std::atomic<int> state{0}; // 0 running, 1 done, 2 failed
+        std::atomic<size_t> total{0};
+        std::atomic<size_t> exported{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<int64_t> elapsedUs{0};
+        std::string error; // set before state becomes failed
+    };
+
+    static constexpr size_t KEEP_JOBS = 16; // finished jobs remembered for status()
+
+    AccountExporter() = default;
+    AccountExporter(const AccountExporter&) = delete;
+    AccountExporter& operator=(const AccountExporter&) = delete;
+
+    bool resolvePath(const std::string& path, std::string& resolved, std::string& error) const; // mtx held
+    static void run(const AccountRegistry& registry, const std::shared_ptr<Job>& job);
+    void finished();
+
+    mutable std::mutex mtx;
+    ExportConfig config;
+    std::map<uint64_t, std::shared_ptr<Job>> jobs;
+    uint64_t nextId = 1;
+    size_t running = 0;
+};
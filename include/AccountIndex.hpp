@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Open-addressing (linear probing) hash table mapping account numbers to
+// their slot in Bank's account storage. Entries are 8 bytes and stored
+// inline so a lookup touches one or two cache lines.
+class AccountIndex{
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    AccountIndex();
+
+    size_t find(int accNum) const;
+    void insert(int accNum, size_t slot); // inserts or updates
+    bool erase(int accNum);
+    void reserve(size_t count);
+    void clear();
+    size_t size() const;
+private:
+    struct Entry{
+        int key;
+        uint32_t slot;
+    };
+
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    size_t bucketFor(int accNum) const;
+    void rehash(size_t newCapacity);
+
+    std::vector<Entry> table;
+    size_t mask;
+    size_t count;
+    int shift;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Account.hpp"
+#include "AccountIndex.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+// Concurrent account table. Accounts are spread over fixed shards by account
+// number; each shard has its own reader/writer lock, storage and index, so
+// creates and closes on different shards run in parallel and lookups only
+// take a shared lock on one shard. Accounts are handed out as shared_ptr so a
+// request thread can keep using an account even if another thread closes it.
+class AccountRegistry{
+public:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    std::shared_ptr<Account> find(int accNum) const;
+    bool contains(int accNum) const;
+    bool insert(std::shared_ptr<Account> acc); // false if the number is taken
+    std::shared_ptr<Account> erase(int accNum);
+    void clear(); // in one step, releasing the storage
+    void reserve(size_t count);
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // CLOCK eviction for the hot-set cache: sweeps shards round robin and
+    // removes up to n accounts that nothing outside the registry holds (no
+    // request, write-behind flush, snapshot or export) and that Redis has
+    // up to date, skipping, and clearing the reference bit of, any account
+    // used since the hand last passed. Returns how many were removed.
+    size_t evict(size_t n);
+
+    // Copy of one shard's accounts, for work partitioned by shard
+    std::vector<std::shared_ptr<Account>> shardSnapshot(size_t shard) const;
+
+    // Appends the accounts in slots [from, from + maxSlots) of one shard to
+    // out and returns the slot to resume from, or SHARD_END once the shard is
+    // exhausted. Accounts keep their slot for life (closing one leaves a hole
+    // that a later insert reuses), so walking a shard this way visits every
+    // account present throughout the walk exactly once.
+    static constexpr size_t SHARD_END = static_cast<size_t>(-1);
+    size_t shardRange(size_t shard, size_t from, size_t maxSlots, std::vector<std::shared_ptr<Account>>& out) const;
+
+    // Calls fn for every account. Each shard is copied under its shared lock
+    // and fn runs unlocked, so fn may block (e.g. on Redis) without stalling
+    // writers to that shard.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for(size_t shard = 0; shard < SHARD_COUNT; ++shard){
+            for(const auto& acc : shardSnapshot(shard)){
+                fn(acc);
+            }
+        }
+    }
+private:
+    struct alignas(64) Shard{
+        mutable std::shared_mutex mtx;
+        std::vector<std::shared_ptr<Account>> accounts; // null where an account was closed
+        std::vector<size_t> freeSlots; // holes in accounts, reused first by insert
+        AccountIndex index; // account number -> position in accounts
+        size_t clockHand = 0; // next slot evict() looks at
+    };
+
+    static size_t shardFor(int accNum);
+    static std::shared_ptr<Account> removeSlot(Shard& shard, size_t pos, int accNum); // shard locked
+
+    std::array<Shard, SHARD_COUNT> shards;
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> clockShard{0};
+};
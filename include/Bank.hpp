@@ -1,15 +1,47 @@
 #pragma once
 
 #include "RedisCache.hpp"
-#include "SavingsAccount.hpp"
-#include "CheckingAccount.hpp"
+#include "WriteBehindQueue.hpp"
+#include "AccountDispatch.hpp"
+#include "AccountRegistry.hpp"
+#include "InterestEngine.hpp"
+#include "Journal.hpp"
+#include "Snapshot.hpp"
+#include "AccountExporter.hpp"
+#include "BinaryProtocol.hpp"
+#include "BloomFilter.hpp"
+#include <array>
 #include <algorithm>
 #include <vector>
 #include <memory>
 #include <chrono>
 #include <thread>
 #include <limits>
-#include <typeinfo>
+#include <atomic>
+#include <shared_mutex>
+#include <optional>
+
+// Outcome of a single-account DEPOSIT/WITHDRAW, for callers that format the
+// response themselves (see Bank::balanceMessage)
+struct BalanceResult{
+    enum Code : uint8_t{
+        OK,
+        NOT_FOUND,
+        NEGATIVE_AMOUNT,
+        INSUFFICIENT_FUNDS,
+        OUT_OF_RANGE, // the new balance would overflow
+        NOT_DURABLE // applied, but the journal could not make it durable
+    };
+    Code code = OK;
+    AccountType type = AccountType::SAVINGS; // the insufficient-funds text depends on it
+    Money balance = 0; // new balance when OK
+};
+
+// One DISPLAY_ALL page; nextCursor is 0 once the table has been walked
+struct AccountPage{
+    std::vector<AccountImage> accounts;
+    uint64_t nextCursor = 0;
+};
 
 class Bank{
 public:
@@ -27,17 +59,131 @@ public:
     json modifyAccount(const json& accJson);
     json applyInterestOne(const json& accJson);
     json applyInterestAll(const json& accJson);
+    json batch(const json& accJson);
+    json transferBatch(const json& accJson);
+
+    // Typed operations behind the JSON entry points above, shared with the
+    // binary protocol
+    json createAccount(AccountType accountType, int accNum, const std::string& name, Money balance, Rate rate, int overdraft);
+    json deposit(int accNum, Money amount);
+    json withdraw(int accNum, Money amount);
+    json transfer(int accNum1, int accNum2, Money amount);
+    json displayAccount(int accNum);
+    json closeAccount(int accNum);
+    json modifyAccount(int accNum, const std::string& newName, Money newBalance, Rate newInterestRate, int newOverdraftLimit);
+    json applyInterestOne(int accNum);
 
+    // Allocation-free DEPOSIT/WITHDRAW: the result is a value and the reply
+    // text is written into a caller's buffer of BALANCE_MESSAGE_MAX bytes,
+    // so in steady state the whole operation (including the journal append
+    // and the write-behind enqueue) never touches the heap
+    BalanceResult depositBalance(int accNum, Money amount);
+    BalanceResult withdrawBalance(int accNum, Money amount);
+    static constexpr size_t BALANCE_MESSAGE_MAX = 64;
+    static std::string_view balanceMessage(const BalanceResult& result, bool deposit, int accNum, char* buf);
+    // Fills page with up to limit accounts in registry order starting at
+    // cursor (0 = the first page); false if the cursor is not one we issued.
+    // Only the slots the page covers are visited, so the cost of a page does
+    // not depend on the size of the table.
+    bool listAccounts(uint64_t cursor, size_t limit, std::optional<AccountType> type, AccountPage& page) const;
+
+    static constexpr size_t DEFAULT_PAGE_SIZE = 100;
+    static constexpr size_t MAX_PAGE_SIZE = 1000;
+
+    // Writes the accounts Redis is behind on (changed since their last
+    // successful write) and waits for them; the rest count as skipped
     json saveAllAccounts() const;
-    json displayAllAccounts() const;
-    json exportAllAccountsToFile() const;  
+    // Paged listing: optional "cursor" (from the previous page's
+    // "nextCursor"), "limit" and "accountType" filter
+    json displayAllAccounts(const json& accJson) const;
     json loadAllAccounts();
     json deleteAllAccounts();
 
-    bool accountExists(int accNum) const;
-    Account* findAccount(int accNum) const;
+    // EXPORT_JSON starts a background export job and answers with its id
+    // straight away; EXPORT_STATUS reports the job's progress
+    json exportAllAccountsToFile(const json& accJson) const;
+    json exportAllAccountsToFile(ExportFormat format = ExportFormat::JSON, const std::string& path = "accounts_export.json") const;
+    json exportStatus(const json& accJson) const;
+
+    // Binary snapshots of the table at path, rewritten every interval in the
+    // background (0 disables the timer); loadAllAccounts prefers a usable
+    // snapshot over Redis
+    void configureSnapshots(const std::string& path, std::chrono::seconds interval);
+    json writeSnapshot();
+
+    // Hot-set cache mode: keep at most maxAccounts in memory and load the
+    // rest from Redis when a request needs them, evicting cold accounts
+    // whose changes have reached Redis. Call before configureSnapshots and
+    // loadAllAccounts; 0 (the default) keeps the whole table in memory.
+    // Snapshots, DISPLAY_ALL and EXPORT_JSON need the whole table and are
+    // off in this mode.
+    void configureHotSet(size_t maxAccounts);
+    bool wholeTableInMemory() const { return hotSetCapacity == 0; }
+    // Rough heap cost of one resident account (object, control block,
+    // registry slot and index entry), for sizing maxAccounts from a budget
+    static constexpr size_t HOT_SET_ACCOUNT_BYTES = 256;
+    json cacheStats() const;
+
+    // In hot-set mode these may load the account from Redis
+    bool accountExists(int accNum);
+    std::shared_ptr<Account> findAccount(int accNum);
+    size_t accountCount() const; // in memory
 private:
-    std::vector<std::unique_ptr<Account>> accounts;
+    AccountRegistry accounts;
+
+    size_t hotSetCapacity = 0;
+    BloomFilter knownAccounts; // every account number in Redis or created since
+    // a miss loads, and a close removes, an account under its stripe, so a
+    // slow load can never bring back an account closed meanwhile
+    static constexpr size_t LOAD_STRIPES = 256;
+    std::array<std::mutex, LOAD_STRIPES> loadStripes;
+    std::mutex& loadStripe(int accNum){ return loadStripes[static_cast<uint32_t>(accNum) % LOAD_STRIPES]; }
+    std::atomic<uint64_t> cacheLoads{0};
+    std::atomic<uint64_t> cacheBloomRejects{0};
+    std::atomic<uint64_t> cacheAbsent{0}; // bloom false positives and accounts being deleted
+    std::atomic<uint64_t> cacheEvictions{0};
+    std::shared_ptr<Account> loadOnMiss(int accNum);
+    void evictIfNeeded();
+    json applyInterestAllHotSet();
+    json needsWholeTable(const char* action) const;
+
+    // Mutations shared by the single-request and BATCH paths; they do not
+    // persist. The caller holds acc.lock(), and an account closed since its
+    // lookup is reported not found
+    static BalanceResult depositLocked(Account& acc, Money amount);
+    static BalanceResult withdrawLocked(Account& acc, Money amount);
+    json depositTo(Account& acc, Money amount);
+    json withdrawFrom(Account& acc, Money amount);
+    json applyModification(Account& acc, const std::string& newName, Money newBalance, Rate newInterestRate, int newOverdraftLimit);
+    json transferLocked(Account& to, Account& from, Money amount); // caller holds both lock()s
+    // Journal the accounts' current state, wait for the commit, then queue
+    // them for write-behind; false when the journal commit failed. May wait
+    // on an fdatasync and, through checkpointIfNeeded, on Redis, so the
+    // event loop never runs a mutation on its own thread
+    bool persist(const std::shared_ptr<Account>& acc);
+    bool persist(const std::vector<std::shared_ptr<Account>>& accs);
+    static void markNotDurable(json& msg); // turns a reply into a failure after a failed commit
+    // Flushes the write-behind queue and empties the journal, unless Redis
+    // did not take every write; false then, or when no new journal file
+    // could be started
+    bool checkpoint() const;
+    void checkpointIfNeeded() const;
+    static constexpr std::chrono::seconds CHECKPOINT_RETRY{1};
+    mutable std::atomic<int64_t> checkpointRetryAt{0}; // steady_clock ticks
+    size_t replayJournal();
+    void refreshSnapshot(); // background writeSnapshot after a boot that moved the journal base
+    bool loadSnapshot(size_t& loaded);
+
+    // journal appends through their write-behind enqueue hold this shared;
+    // a checkpoint holds it exclusively so nothing slips between the final
+    // flush and the journal reset. Always taken before any account lock.
+    mutable std::shared_mutex checkpointGate;
+
+    std::string snapshotPath;
+    std::mutex snapshotMtx; // one snapshot writer at a time
+    // set once loadAllAccounts has the complete table; until then a snapshot
+    // would record missing accounts as gone at the current journal LSN
+    std::atomic<bool> tableLoaded{false};
 
     Bank() = default; // private constructor
     Bank(const Bank&) = delete; // delete copy constructor
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "Money.hpp"
+
+// Compact binary encoding of the bank protocol, negotiated per connection by
+// sending {"action": "HELLO", "protocol": "binary"} as the first (JSON)
+// frame. Every later frame on that connection is binary: one opcode byte
+// followed by the fixed little-endian layout for that action. Strings are a
+// u16 length followed by the bytes. Amounts and balances are i64 cents;
+// rateOrLimit is the interest rate in millionths (SAVINGS) or the overdraft
+// limit in whole units (CHECKING).
+//
+//   CREATE             u8 accountType, i32 accountNumber, i64 balance, i64 rateOrLimit, str holderName
+//   MODIFY             i32 accountNumber, i64 balance, i64 rateOrLimit, str holderName
+//                      (0 and an empty name leave a field unchanged)
+//   DEPOSIT/WITHDRAW   i32 accountNumber, i64 amount
+//   TRANSFER           i32 accountNumber1 (to), i32 accountNumber2 (from), i64 amount
+//   DELETE/DISPLAY_ONE/APPLY_INTEREST_ONE
+//                      i32 accountNumber
+//   DISPLAY_ALL        u8 accountType (0 = any), u64 cursor, u32 limit, or no
+//                      fields for the first page with the default size
+//   everything else    no fields
+//
+// Responses are u8 status (0 success, 1 failed) followed by the UTF-8
+// message, except DISPLAY_ALL which answers u8 status, u64 nextCursor
+// (0 after the last page), u32 count and then count records of
+// u8 accountType, i32 accountNumber, i64 balance, i64 rateOrLimit,
+// str holderName.
+
+enum class Opcode : uint8_t{
+    CREATE = 1,
+    DELETE = 2,
+    MODIFY = 3,
+    DEPOSIT = 4,
+    WITHDRAW = 5,
+    TRANSFER = 6,
+    APPLY_INTEREST_ONE = 7,
+    APPLY_INTEREST_ALL = 8,
+    DISPLAY_ONE = 9,
+    DISPLAY_ALL = 10,
+    DELETE_ALL = 11,
+    EXPORT_JSON = 12,
+    EXIT = 13
+};
+
+enum class AccountKind : uint8_t{
+    ANY = 0, // DISPLAY_ALL filter only
+    SAVINGS = 1,
+    CHECKING = 2
+};
+
+struct BinaryRequest{
+    Opcode op = Opcode::EXIT;
+    AccountKind accountType = AccountKind::SAVINGS;
+    int32_t accountNumber = 0;
+    int32_t accountNumber2 = 0;
+    Money amount = 0;
+    Money balance = 0;
+    int64_t rateOrLimit = 0; // interest rate (SAVINGS) or overdraft limit (CHECKING)
+    uint64_t cursor = 0; // DISPLAY_ALL
+    uint32_t limit = 0;  // DISPLAY_ALL page size, 0 = server default
+    std::string_view holderName; // points into the decoded frame
+};
+
+struct BinaryAccount{
+    AccountKind accountType;
+    int32_t accountNumber;
+    Money balance;
+    int64_t rateOrLimit;
+    std::string holderName;
+};
+
+void encodeRequest(const BinaryRequest& req, std::string& out);
+bool decodeRequest(std::string_view payload, BinaryRequest& req);
+
+void encodeResponse(bool success, std::string_view message, std::string& out);
+bool decodeResponse(std::string_view payload, bool& success, std::string_view& message);
+
+void encodeAccountList(const std::vector<BinaryAccount>& accounts, uint64_t nextCursor, std::string& out);
+bool decodeAccountList(std::string_view payload, std::vector<BinaryAccount>& accounts, uint64_t& nextCursor);
+
+// DISPLAY_ALL page cursors are opaque u64 tokens; JSON carries them as this
+// hex text
+std::string cursorToString(uint64_t cursor);
+bool parseCursor(std::string_view text, uint64_t& cursor);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bloom filter over account numbers: "no" is certain, "maybe" is wrong for
+// about 1% of absent numbers at the sized load (10 bits and 7 probes per
+// number). add() and mayContain() are safe to call concurrently. There is no
+// removal, so a closed account keeps answering "maybe", which only costs the
+// lookup the filter would otherwise have saved.
+class BloomFilter{
+public:
+    static constexpr size_t BITS_PER_ITEM = 10;
+    static constexpr int PROBES = 7;
+
+    // Sizes the filter for expected numbers and empties it; not concurrent
+    // with add/mayContain. Until the first reset every number is a "maybe".
+    void reset(size_t expected);
+    // Empties the filter, keeping its size; safe alongside add/mayContain
+    void clear();
+    void add(int key);
+    bool mayContain(int key) const;
+    size_t bytes() const { return words ? (mask + 1) / 8 : 0; }
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+    uint64_t mask = 0; // bit count - 1, a power of two
+};
@@ -2,18 +2,26 @@
 
 #include "Account.hpp"
 
-class CheckingAccount : public Account{
+class CheckingAccount final : public Account{
 public:
-    CheckingAccount(int accNum, const std::string& name, double balance, int limit) : Account(accNum, name, balance), overdraftLimit(limit) {};
+    static constexpr AccountType TYPE = AccountType::CHECKING;
+
+    CheckingAccount(int accNum, const std::string& name, Money balance, int limit) : Account(TYPE, accNum, name, balance), overdraftLimit(limit) {};
     
-    json withdraw(double amount) override;
-    json display() const override;
-    json toJson() const override;
-    std::string getHolderName() const override;
-    std::string getAccountType() const override;
+    // Reached through Account's tag dispatch
+    json withdraw(Money amount);
+    bool canWithdrawLocked(Money amount) const {
+        Money after;
+        return money::sub(balance, amount, after) && after >= -money::fromUnits(overdraftLimit);
+    }
+    AccountImage imageLocked() const { return {TYPE, accountNumber, holderName, balance, overdraftLimit}; }
+    json display() const;
+    json toJson() const;
 
     void setOverDraftLimit(int newLimit);
     int getOverDraftLimit() const;
+    int getOverDraftLimitLocked() const { return overdraftLimit; } // caller holds lock()
+    void setOverDraftLimitLocked(int newLimit){ overdraftLimit = newLimit; }
 private:
-    int overdraftLimit;
+    int overdraftLimit; // whole currency units
 };
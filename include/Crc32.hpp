@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, as used by zlib). Pass the previous result as crc to
+// checksum data in pieces.
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
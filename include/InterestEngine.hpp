@@ -0,0 +1,26 @@
+#pragma once
+
+#include "AccountRegistry.hpp"
+#include "SavingsAccount.hpp"
+
+// Month-end interest over the whole registry. Worker threads each take a
+// registry shard, lock its savings accounts in ascending account order,
+// gather balances and rates into flat int64 arrays, run
+// balance += interestOn(balance, rate) as one tight loop, and scatter the
+// results back. Balances whose interest would overflow are left unchanged
+// and counted.
+class InterestEngine{
+public:
+    struct Result{
+        size_t accounts = 0;
+        size_t overflowed = 0;
+        double seconds = 0.0;
+        std::vector<std::shared_ptr<Account>> updated; // for persistence
+    };
+
+    static Result applyAll(const AccountRegistry& registry, size_t threads);
+
+    // The data-parallel kernel: balances[i] += interestOn(balances[i], rates[i]).
+    // Returns how many balances were skipped because the result would overflow.
+    static size_t applyKernel(Money* balances, const Rate* rates, size_t count);
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Account.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class FsyncPolicy{
+    NONE,   // write(2) only; the OS decides when data reaches the disk
+    GROUP,  // one fdatasync covers every entry appended before it (group commit)
+    ALWAYS  // fdatasync each entry on its own
+};
+
+struct JournalConfig{
+    std::string path = "bank.journal";
+    FsyncPolicy policy = FsyncPolicy::GROUP;
+    std::chrono::microseconds groupDelay{0}; // GROUP: leader waits this long for followers
+    size_t checkpointBytes = 64 << 20; // ask for a checkpoint past this size
+};
+
+enum class JournalOp : uint8_t{
+    SAVE = 1,   // image is the account's full state after the mutation
+    DELETE = 2  // only image.accountNumber is meaningful
+};
+
+struct JournalRecord{
+    JournalOp op = JournalOp::SAVE;
+    AccountImage image;
+};
+
+// Append-only binary write-ahead journal of account after-images. Bank
+// appends a record while still holding the account's lock, so per account
+// the journal order is the mutation order, then calls commit() before
+// answering. Replaying the journal on top of the last persisted (Redis)
+// state restores every committed mutation.
+//
+// The file starts with the 8-byte magic "BANKJRNL" and the u64 base LSN:
+// every entry up to the base is already persisted elsewhere (the last
+// checkpoint), so a snapshot is only usable with this journal if it covers
+// the base. Then each entry is
+//   u32 bodyLength, u32 crc32(body), body = u64 lsn, u32 count, count records
+// and a record is u8 op, i32 accountNumber, then for SAVE u8 accountType,
+// i64 balance, i64 rateOrLimit, u16 nameLength, name (little-endian). The
+// records of one entry are applied all or nothing, so a torn tail after a
+// crash drops whole entries only.
+class Journal{
+public:
+    static Journal& getInstance(){
+        static Journal instance;
+        return instance;
+    }
+
+    // (Re)opens the journal file; appends go after the entries already in it
+    bool open(const JournalConfig& config);
+    bool isOpen() const;
+
+    // Appends one entry and returns its LSN (0 when the journal is closed).
+    // Call with the locks of every account in the records held.
+    uint64_t append(const std::vector<JournalRecord>& records);
+    uint64_t appendSave(const AccountImage& image);
+    uint64_t appendDelete(int accNum);
+
+    // Returns once the entry with this LSN is durable under the fsync policy.
+    // False when it is not: a write or fdatasync failed, and from then on
+    // appends are refused and commits fail until a reset() starts a new file
+    bool commit(uint64_t lsn);
+
+    // Calls apply for every record of every intact entry in file order,
+    // truncates a torn tail, and returns the number of records replayed
+    size_t replay(const std::function<void(const JournalRecord&)>& apply);
+
+    // Empties the journal, moving the base up to the last appended LSN; call
+    // only once everything in it is persisted elsewhere and no append can
+    // race the reset. False when the new file could not be created
+    bool reset();
+    bool needsCheckpoint() const; // also true once failed, to get a reset
+    bool hasFailed() const;
+
+    uint64_t lastLsn() const; // last appended
+    uint64_t baseLsn() const;
+
+    json stats() const;
+private:
+    Journal() = default;
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Frames one entry of count records written by encode(buffer)
+    template <typename Encode>
+    uint64_t appendEntry(uint32_t count, Encode&& encode);
+    void closeLocked();
+    void failLocked(int err); // a write/fdatasync failed: nothing past durableLsn is on disk
+    bool createLocked(uint64_t newBase); // atomically replaces the file with an empty journal
+
+    mutable std::mutex mtx;
+    std::condition_variable synced;
+    JournalConfig config;
+    int fd = -1;
+    std::string buffer; // appended, not yet written
+    std::string writing; // the leader's batch; only touched while syncing
+    uint64_t nextLsn = 1;
+    uint64_t appendedLsn = 0;
+    uint64_t durableLsn = 0;
+    uint64_t base = 0;
+    bool syncing = false; // a leader is writing/syncing
+    bool failed = false;
+    size_t fileBytes = 0;
+
+    // metrics
+    uint64_t entries = 0;
+    uint64_t records = 0;
+    uint64_t syncs = 0;
+    uint64_t syncedEntries = 0;
+    uint64_t totalSyncUs = 0;
+    uint64_t maxSyncUs = 0;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Money.hpp"
+#include "RequestDecoder.hpp"
+#include <string>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Field readers for requests parsed into a json DOM. Numbers travel as
+// strings; a missing or malformed field fails with the same text the
+// one-pass RequestDecoder path gives (see fields::message) and fills msg
+// with the failed reply.
+
+inline void fieldFailed(fields::Error error, const std::string& key, json& msg){
+    msg["status"] = "failed: ";
+    msg["message"] = fields::message(error, key);
+}
+
+template <typename T>
+bool validateJsonField(const json& obj, const std::string& key, json& msg, T& out){
+    auto it = obj.find(key);
+    if(it == obj.end()){
+        fieldFailed(fields::Error::MISSING, key, msg);
+        return false;
+    }
+
+    if constexpr (std::is_same_v<T, std::string>){
+        out = it->template get<T>();
+        return true;
+    }else{
+        // numbers travel as strings; a non-string throws json::type_error
+        const std::string& strVal = it->template get_ref<const std::string&>();
+        fields::Error error;
+        if constexpr (std::is_same_v<T, int>){
+            error = fields::parseInt(strVal, out);
+        }else if constexpr (std::is_same_v<T, Money>){
+            // exact fixed-point parse: no float round trip, no locale, no exceptions
+            error = fields::parseAmount(strVal, out);
+        }else{
+            static_assert(sizeof(T) == 0, "unsupported request field type");
+        }
+
+        if(error != fields::Error::OK){
+            fieldFailed(error, key, msg);
+            return false;
+        }
+        return true;
+    }
+}
+
+// Interest rates share Money's representation, so they need their own entry point
+inline bool validateRateField(const json& obj, const std::string& key, json& msg, Rate& out){
+    std::string strVal;
+
+    if(!validateJsonField(obj, key, msg, strVal)){
+        return false;
+    }
+
+    fields::Error error = fields::parseRate(strVal, out);
+    if(error != fields::Error::OK){
+        fieldFailed(error, key, msg);
+        return false;
+    }
+    return true;
+}
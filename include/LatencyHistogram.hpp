@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear latency histogram in nanoseconds, in the style of
+// HdrHistogram: values below 128 ns get a bucket each, and above that every
+// power of two is split into 64 buckets, so any recorded value is reported
+// within 1/64 (~1.6%) of itself. Values from 0 ns up to ~68 s (2^36 ns) are
+// covered; larger ones land in the top bucket.
+//
+// record() is a handful of integer instructions and no atomic read-modify-
+// write: each histogram has one writer thread, while other threads may read
+// it (or merge it into their own) at any time and see a slightly stale but
+// consistent-enough view. Give each recording thread its own histogram and
+// merge them for reporting.
+class LatencyHistogram{
+public:
+    static constexpr int SUB_BITS = 6;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BITS;
+    static constexpr int MAX_BITS = 36;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram& other);
+    LatencyHistogram& operator=(const LatencyHistogram& other);
+
+    // Single writer only
+    void record(uint64_t ns){
+        size_t i = bucketOf(ns);
+        counts[i].store(counts[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if(ns > maxValue.load(std::memory_order_relaxed)){
+            maxValue.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds other's counts into this one (this histogram's writer only)
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Smallest recorded value v such that percent% of the values are <= v,
+    // reported as the top of its bucket (never above max()); 0 when empty
+    uint64_t percentile(double percent) const;
+
+    static size_t bucketOf(uint64_t ns){
+        if(ns < 2 * SUB_BUCKETS){
+            return static_cast<size_t>(ns);
+        }
+        int shift = 63 - __builtin_clzll(ns) - SUB_BITS;
+        if(shift >= MAX_BITS - SUB_BITS){
+            return BUCKETS - 1;
+        }
+        return static_cast<size_t>(shift) * SUB_BUCKETS + static_cast<size_t>(ns >> shift);
+    }
+    static uint64_t bucketTop(size_t bucket);
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maxValue{0};
+};
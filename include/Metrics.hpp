@@ -0,0 +1,95 @@
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Request actions as counted by Metrics; INVALID covers malformed requests
+// and unknown actions
+enum class RequestKind : uint8_t{
+    CREATE, DELETE, MODIFY, DEPOSIT, WITHDRAW, TRANSFER, BATCH, TRANSFER_BATCH,
+    APPLY_INTEREST_ONE, APPLY_INTEREST_ALL, DISPLAY_ONE, DISPLAY_ALL, DELETE_ALL,
+    EXPORT_JSON, EXPORT_STATUS, SNAPSHOT, STATS, HELLO, EXIT, INVALID,
+    COUNT
+};
+
+enum class RedisCall : uint8_t{
+    SAVE, WRITE_BATCH, LOAD, LOAD_BATCH, DELETE, DELETE_ALL, SCAN,
+    COUNT
+};
+
+const char* requestKindName(RequestKind kind);
+RequestKind requestKindFromName(std::string_view action);
+const char* redisCallName(RedisCall call);
+
+// Server instrumentation: per-action request and error counts with latency
+// histograms, RedisCache call latencies, and the live connection count.
+// Each thread records into its own histograms (no locks, no atomic
+// read-modify-write), which are allocated the first time the thread sees an
+// action and handed on to a later thread when it exits. Reports merge them.
+class Metrics{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static Metrics& getInstance(){
+        static Metrics instance;
+        return instance;
+    }
+
+    void recordRequest(RequestKind kind, bool ok, Clock::duration elapsed);
+    void recordRedis(RedisCall call, Clock::duration elapsed);
+    void connectionOpened(){ connections.fetch_add(1, std::memory_order_relaxed); }
+    void connectionClosed(){ connections.fetch_sub(1, std::memory_order_relaxed); }
+
+    // STATS fields: "requests" and "redis" by name (only those seen so far),
+    // "connections" and "accounts"
+    json stats() const;
+    // The same in Prometheus text exposition format
+    std::string prometheus() const;
+    // Rewrites path with prometheus() every interval from a background
+    // thread, replacing it atomically so scrapers never see a partial file
+    void startExporter(const std::string& path, std::chrono::seconds interval);
+
+    struct ThreadMetrics;
+private:
+    Metrics();
+    ~Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    ThreadMetrics& local();
+    void release(ThreadMetrics* metrics);
+    void merge(std::array<LatencyHistogram, static_cast<size_t>(RequestKind::COUNT)>& requests,
+               std::array<uint64_t, static_cast<size_t>(RequestKind::COUNT)>& errors,
+               std::array<LatencyHistogram, static_cast<size_t>(RedisCall::COUNT)>& redis) const;
+    bool writeFile(const std::string& path) const;
+
+    std::atomic<int64_t> connections{0};
+    mutable std::mutex mtx; // guards the two lists below
+    std::vector<std::unique_ptr<ThreadMetrics>> all;
+    std::vector<ThreadMetrics*> idle; // released by exited threads
+
+    friend struct MetricsHandle;
+};
+
+// Times one scope into a RedisCache call histogram
+class RedisTimer{
+public:
+    explicit RedisTimer(RedisCall call) : call(call), start(Metrics::Clock::now()) {}
+    ~RedisTimer(){ Metrics::getInstance().recordRedis(call, Metrics::Clock::now() - start); }
+    RedisTimer(const RedisTimer&) = delete;
+    RedisTimer& operator=(const RedisTimer&) = delete;
+private:
+    RedisCall call;
+    Metrics::Clock::time_point start;
+};
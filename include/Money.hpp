@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Money is a signed count of minor units (cents), so balances are exact and
+// bulk kernels can run over plain int64 arrays. Interest rates are fixed
+// point as well, in millionths (0.035 == 35000).
+using Money = std::int64_t;
+using Rate = std::int64_t;
+
+namespace money{
+    constexpr int CENT_DIGITS = 2;
+    constexpr std::int64_t CENTS_PER_UNIT = 100;
+    constexpr int RATE_DIGITS = 6;
+    constexpr std::int64_t RATE_SCALE = 1000000;
+    constexpr size_t MAX_CHARS = 24; // "-92233720368547758.07" plus slack
+
+    // Parses an optionally signed decimal ("12", "-0.5", "12.34") into an
+    // integer scaled by 10^digits. More than `digits` decimals are rejected
+    // unless roundExcess is set, in which case they round half away from zero.
+    bool parseFixed(std::string_view text, int digits, std::int64_t& out, bool roundExcess = false);
+
+    // Writes value / 10^digits; returns one past the last character written.
+    // trimZeros drops trailing fractional zeros (and a bare '.').
+    char* formatFixed(std::int64_t value, int digits, char* out, bool trimZeros = false);
+
+    bool parse(std::string_view text, Money& out);
+    bool parseRate(std::string_view text, Rate& out);
+    std::string toString(Money amount); // "1234.50"
+    std::string rateToString(Rate rate); // "0.035"
+
+    // Largest amount, balance or rate a request may carry ($10 trillion and
+    // 1000%). Far inside int64, but balances still accumulate, so every
+    // balance update goes through the checked helpers below.
+    constexpr Money MAX_AMOUNT = 1000000000000000;
+    constexpr Rate MAX_RATE = 10 * RATE_SCALE;
+
+    inline Money fromUnits(std::int64_t units){
+        return units * CENTS_PER_UNIT;
+    }
+
+    // a + b / a - b; false (out untouched) when the result does not fit
+    inline bool add(Money a, Money b, Money& out){
+        Money sum;
+        if(__builtin_add_overflow(a, b, &sum)) return false;
+        out = sum;
+        return true;
+    }
+
+    inline bool sub(Money a, Money b, Money& out){
+        Money diff;
+        if(__builtin_sub_overflow(a, b, &diff)) return false;
+        out = diff;
+        return true;
+    }
+
+    // balance * rate rounded half away from zero; false when the product
+    // does not fit in int64.
+    inline bool interestOn(Money balance, Rate rate, Money& out){
+        std::int64_t scaled;
+        if(__builtin_mul_overflow(balance, rate, &scaled)) return false;
+        std::int64_t quot = scaled / RATE_SCALE;
+        std::int64_t rem = scaled % RATE_SCALE;
+        quot += (rem >= RATE_SCALE / 2) - (rem <= -RATE_SCALE / 2);
+        out = quot;
+        return true;
+    }
+}
@@ -1,13 +1,56 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstdint>
 #include <unistd.h>
 #include <sys/socket.h>
 
 constexpr int PORT = 6000;
-constexpr int BUFFER_SIZE = 4096;
+constexpr int BUFFER_SIZE = 64 * 1024;
 constexpr const char* SERVER_IP = "127.0.0.1";
 
+// Every message on the wire is a frame: a 4-byte big-endian payload length
+// followed by the payload. Frames may be pipelined back to back. A header
+// announcing more than MAX_FRAME_SIZE closes the connection, which bounds
+// what one client can make the server buffer.
+constexpr size_t FRAME_HEADER_SIZE = 4;
+constexpr size_t MAX_FRAME_SIZE = 4u << 20;
+
 std::string recieveMessage(int socketFD);
-bool sendMessage(int socketFD, const std::string& message);
\ No newline at end of file
+bool sendMessage(int socketFD, const std::string& message);
+
+// Appends one framed payload to out, so several responses can be coalesced
+// into a single send.
+void appendFrame(std::string& out, std::string_view payload);
+// Builds a frame in place: reserve the header, append the payload to out,
+// then patch the length in. Saves the copy (and scratch buffer) of
+// appendFrame on the hot path.
+size_t beginFrame(std::string& out);
+void endFrame(std::string& out, size_t start);
+// Writes all of data, retrying partial sends.
+bool sendAll(int socketFD, const char* data, size_t size);
+
+// Accumulates bytes from a stream socket and splits them into frames.
+class FrameReader{
+public:
+    // Reads whatever is available (up to BUFFER_SIZE) from the socket.
+    // Returns bytes read, 0 on EOF, -1 on error (errno is preserved).
+    ssize_t readFrom(int socketFD);
+    void append(const char* data, size_t size);
+
+    // Extracts the next complete frame. The view stays valid until the next
+    // call to readFrom/append/compact.
+    bool nextFrame(std::string_view& payload);
+    // True if a frame header announced a payload larger than MAX_FRAME_SIZE.
+    bool oversized() const;
+    // Bytes received but not yet returned by nextFrame.
+    size_t buffered() const { return buffer.size() - readPos; }
+    // Drops consumed bytes from the front of the buffer.
+    void compact();
+private:
+    std::string buffer;
+    size_t readPos = 0;
+    bool tooLarge = false;
+};
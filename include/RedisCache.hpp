@@ -1,27 +1,80 @@
 #pragma once
 
 #include <sw/redis++/redis++.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <memory>
 #include <iterator>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include "SavingsAccount.hpp"
 #include "CheckingAccount.hpp"
 
+// Where the shared RedisCache connects, and how
+struct RedisConfig{
+    std::string host = "127.0.0.1";
+    int port = 6379;
+    size_t poolSize = 4; // connections shared by every thread
+    std::chrono::milliseconds connectTimeout{1000};
+    std::chrono::milliseconds socketTimeout{0}; // per command, 0 waits forever
+    std::chrono::milliseconds poolWaitTimeout{0}; // for a free connection, 0 waits forever
+    bool keepAlive = true; // TCP keepalive, so dead peers are noticed
+};
+
 class RedisCache{
 public:
+    // Sets the server getInstance() connects to; only takes effect before
+    // the first getInstance() call
+    static void configure(const RedisConfig& config);
+
     static RedisCache& getInstance(){
-        static RedisCache instance;
+        static RedisCache instance(settings());
         return instance;
     }
 
+    // The server uses getInstance(); benchmarks build their own to compare
+    // pool sizes
+    explicit RedisCache(const RedisConfig& config);
+    ~RedisCache();
+
     void saveAccount(const Account& acc);
+    // Pipelined DEL+SREM for deletes, then HSET+SADD for saves; false (and
+    // the error logged) if Redis did not take the batch
+    bool writeBatch(const std::vector<int>& deletes, const std::vector<std::shared_ptr<Account>>& saves);
+    // writeBatch on one of the cache's I/O threads, which hold one pooled
+    // connection each while writing, so several batches go out at once.
+    // The saved accounts stay referenced until the future is ready
+    std::future<bool> writeBatchAsync(std::vector<int> deletes, std::vector<std::shared_ptr<Account>> saves);
     std::unique_ptr<Account> loadAccount(int accNum);
     void deleteAccount(int accNum);
+    // Removes every account key and the "accounts" set: SSCAN the set for
+    // the keys, UNLINK them in chunks over one pipelined round trip and the
+    // set last; Redis frees the memory in the background. Returns how many
+    // accounts were removed; throws sw::redis::Error
+    size_t deleteAllAccounts();
     std::vector<std::string> getAllAccountKeys();
+
+    // Bulk load: SCAN with a large COUNT, then one pipelined HGETALL round
+    // trip per batch. Each loader thread should use its own pipeline, which
+    // holds a dedicated connection.
+    std::vector<int> getAllAccountNumbers(long long scanCount = 10000);
+    sw::redis::Pipeline newPipeline();
+    void loadAccounts(sw::redis::Pipeline& pipe, const std::vector<int>& accNums, std::vector<std::unique_ptr<Account>>& out);
 private:
-    RedisCache();
+    static RedisConfig& settings();
     RedisCache(const RedisCache&) = delete;
     RedisCache& operator=(const RedisCache&) = delete;
 
+    void runIo();
+
     sw::redis::Redis redis;
+
+    std::mutex ioMtx;
+    std::condition_variable ioReady;
+    std::deque<std::packaged_task<void()>> ioTasks;
+    bool ioStopping = false;
+    std::vector<std::thread> ioThreads;
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Money.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Single-pass decoder for flat JSON requests such as
+//   {"action": "DEPOSIT", "accountNumber": "101", "amount": "25.00"}
+// parse() validates the payload and records where each top-level value
+// sits, without building a DOM or copying anything; the request handler
+// then reads just the fields its action needs.
+//
+// It declines (parse() returns false) anything outside the common case:
+// malformed JSON, a non-object payload, escaped or non-ASCII strings, more
+// than MAX_FIELDS keys or deep nesting. Those requests go to the full JSON
+// parser, which also produces the error reply for malformed ones, so every
+// response is the same whichever path decoded the request.
+class RequestDecoder{
+public:
+    static constexpr size_t MAX_FIELDS = 16;
+    static constexpr int MAX_DEPTH = 32;
+
+    enum class Kind : uint8_t{
+        STRING,
+        NUMBER,
+        LITERAL, // true, false, null
+        OBJECT,
+        ARRAY
+    };
+
+    struct Field{
+        std::string_view key;
+        std::string_view value; // string contents without the quotes, else the raw JSON text
+        Kind kind;
+    };
+
+    bool parse(std::string_view payload);
+
+    // The field's value (the last one if the key repeats), null if absent
+    const Field* find(std::string_view key) const;
+private:
+    bool parseValue(Kind& kind, std::string_view& value, int depth);
+    bool parseString(std::string_view& value);
+    bool parseNumber();
+    bool parseLiteral(std::string_view word);
+    bool parseContainer(char close, int depth);
+    void skipSpace();
+
+    std::string_view text;
+    size_t pos = 0;
+    Field fields[MAX_FIELDS];
+    size_t count = 0;
+};
+
+// Request field conversion shared by the decoder path and the json DOM path
+// (validateJsonField), so both report a bad field with the same text
+namespace fields{
+    enum class Error : uint8_t{
+        OK,
+        MISSING,
+        NOT_A_STRING, // the DOM path raises json::type_error for these
+        INT_CHARACTERS,
+        INT_FORMAT,
+        INT_TRAILING,
+        INT_RANGE,
+        AMOUNT_FORMAT,
+        AMOUNT_RANGE, // beyond +/- money::MAX_AMOUNT
+        RATE_FORMAT,
+        RATE_RANGE // beyond +/- money::MAX_RATE
+    };
+
+    // Decimal int with an optional '-' and nothing else, range checked
+    Error parseInt(std::string_view text, int& out);
+    // Fixed-point amount / rate, limited to the request range in Money.hpp
+    Error parseAmount(std::string_view text, Money& out);
+    Error parseRate(std::string_view text, Rate& out);
+
+    // the same limits for values that arrive already decoded (binary frames)
+    inline bool amountInRange(Money amount){
+        return amount >= -money::MAX_AMOUNT && amount <= money::MAX_AMOUNT;
+    }
+
+    inline bool rateInRange(Rate rate){
+        return rate >= -money::MAX_RATE && rate <= money::MAX_RATE;
+    }
+
+    std::string message(Error error, std::string_view key);
+}
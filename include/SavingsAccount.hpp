@@ -2,19 +2,27 @@
 
 #include "Account.hpp"
 
-class SavingsAccount : public Account{
+class SavingsAccount final : public Account{
 public:
-    SavingsAccount(int accNum, const std::string& name, double balance, double rate) : Account(accNum, name, balance), interestRate(rate) {};
+    static constexpr AccountType TYPE = AccountType::SAVINGS;
 
-    json withdraw(double amount) override;
-    json display() const override;
-    json toJson() const override;
-    std::string getHolderName() const override;
-    std::string getAccountType() const override;
+    SavingsAccount(int accNum, const std::string& name, Money balance, Rate rate) : Account(TYPE, accNum, name, balance), interestRate(rate) {};
+
+    // Reached through Account's tag dispatch
+    json withdraw(Money amount);
+    bool canWithdrawLocked(Money amount) const {
+        Money after;
+        return money::sub(balance, amount, after) && after >= 0;
+    }
+    AccountImage imageLocked() const { return {TYPE, accountNumber, holderName, balance, interestRate}; }
+    json display() const;
+    json toJson() const;
 
     json applyInterest();
-    void setInterestRate(double newRate);
-    double getInterestRate() const;
+    void setInterestRate(Rate newRate);
+    Rate getInterestRate() const;
+    Rate getInterestRateLocked() const { return interestRate; } // caller holds lock()
+    void setInterestRateLocked(Rate newRate){ interestRate = newRate; }
 private:
-    double interestRate;
+    Rate interestRate; // millionths
 };
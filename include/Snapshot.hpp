@@ -0,0 +1,70 @@
+#pragma once
+
+#include "AccountRegistry.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Compact binary image of the whole account table, written next to the
+// journal so a restart can skip Redis. Layout (little-endian, mmap-able):
+//
+//   header   char magic[8] "BANKSNAP", u32 version, u32 recordSize,
+//            u64 count, u64 journalLsn, u64 namesBytes, u32 bodyCrc,
+//            u32 headerCrc (over the preceding header bytes)
+//   records  count x Record, sorted by account number
+//   names    holder names, referenced by Record::nameOffset/nameLength
+//
+// bodyCrc covers records and names. journalLsn is the last journal LSN
+// appended when the capture started: the image includes every entry up to
+// it (and possibly later ones, which replay again harmlessly).
+class Snapshot{
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    struct Record{
+        int32_t accountNumber;
+        uint8_t type; // AccountType
+        uint8_t reserved[3];
+        int64_t balance;
+        int64_t rateOrLimit;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t count;
+        uint64_t journalLsn;
+        uint64_t namesBytes;
+        uint32_t bodyCrc;
+        uint32_t headerCrc;
+    };
+
+    // Captures every account (each under its own lock) and atomically
+    // replaces path with the new image. Returns the number of accounts
+    // written, or -1 on error.
+    static long long write(const std::string& path, const AccountRegistry& registry, uint64_t journalLsn);
+
+    Snapshot() = default;
+    ~Snapshot();
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // Maps the file read-only and validates header, version and checksum
+    bool open(const std::string& path);
+
+    size_t size() const;
+    uint64_t journalLsn() const;
+    AccountImage image(size_t i) const;
+
+    // Builds accounts straight from the mapping on several threads
+    void loadInto(AccountRegistry& registry, size_t threads) const;
+private:
+    void* map = nullptr;
+    size_t mapSize = 0;
+    const Header* header = nullptr;
+    const Record* records = nullptr;
+    const char* names = nullptr;
+};
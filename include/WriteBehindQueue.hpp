@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Account.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct WriteBehindConfig{
+    std::chrono::milliseconds flushInterval{50}; // flush at least this often
+    size_t maxBatch = 1000; // flush early once this many accounts are dirty
+};
+
+// Write-behind stage between Bank and RedisCache. Request threads only mark
+// accounts dirty; a background thread coalesces repeated updates to the same
+// account and writes them to Redis in pipelined batches.
+class WriteBehindQueue{
+public:
+    static WriteBehindQueue& getInstance(){
+        static WriteBehindQueue instance;
+        return instance;
+    }
+
+    void configure(const WriteBehindConfig& config);
+
+    void enqueueSave(const std::shared_ptr<Account>& acc);
+    void enqueueSaves(const std::vector<std::shared_ptr<Account>>& accs); // lands in one flush
+    void enqueueDelete(int accNum);
+    // enqueueSave if acc has changes Redis has not acknowledged; otherwise
+    // counts the write as skipped (as the worker does for queued accounts
+    // an earlier flush already wrote) and returns false
+    bool enqueueIfDirty(const std::shared_ptr<Account>& acc);
+    // True while an update for accNum is queued or being written, i.e.
+    // Redis may not have its latest state yet
+    bool hasPending(int accNum) const;
+
+    // Barrier: waits for a pass over everything enqueued before the call
+    // and returns true only if all of it (and any earlier failed writes) is
+    // in Redis. Failed writes stay queued and are retried on later passes
+    bool flush();
+    // Flushes and stops the background thread (shutdown)
+    void stop();
+
+    json stats() const;
+private:
+    WriteBehindQueue();
+    ~WriteBehindQueue();
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    struct Pending{
+        bool deleteFirst = false; // DEL the key before (optionally) saving
+        std::shared_ptr<Account> acc; // latest state to save, null for delete only
+    };
+
+    void run();
+    void addLocked(int accNum, Pending update);
+    void requeueLocked(); // a failed pass's updates back into pending
+
+    mutable std::mutex mtx;
+    std::condition_variable wakeWorker;
+    std::condition_variable flushed;
+    // Map nodes come from a pool shared by both maps, and the worker swaps
+    // them rather than building a new map per flush, so once warm an
+    // enqueue never reaches the heap
+    std::pmr::synchronized_pool_resource nodePool;
+    std::pmr::unordered_map<int, Pending> pending{&nodePool}; // coalesced by account number
+    std::pmr::unordered_map<int, Pending> inflight{&nodePool}; // the batch being flushed; the worker adds and removes entries only under mtx
+    WriteBehindConfig config;
+    uint64_t configGeneration = 0; // bumped by configure() so the worker restarts its wait
+    uint64_t passesStarted = 0; // flush passes; inflight belongs to the latest
+    uint64_t passesDone = 0;
+    uint64_t flushRequestedPass = 0;
+    bool lastPassOk = true;
+    bool stopping = false;
+    bool stopped = false;
+    std::thread worker;
+
+    // metrics
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> skippedClean{0};
+    std::atomic<uint64_t> failedFlushes{0};
+    std::atomic<uint64_t> flushes{0};
+    std::atomic<uint64_t> flushedAccounts{0};
+    std::atomic<uint64_t> lastFlushUs{0};
+    std::atomic<uint64_t> maxFlushUs{0};
+    std::atomic<uint64_t> totalFlushUs{0};
+};
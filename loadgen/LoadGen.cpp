@@ -0,0 +1,630 @@
+#include "../include/Network.hpp"
+#include "../include/BinaryProtocol.hpp"
+#include "../include/LatencyHistogram.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cerrno>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// Drives a running bank server over many connections with a weighted mix of
+// CREATE, DEPOSIT, WITHDRAW, TRANSFER and DISPLAY_ONE requests and reports
+// throughput and latency percentiles per action.
+//
+// Closed loop (default): every connection keeps --pipeline requests in
+// flight and sends the next one as soon as a response arrives, so the
+// offered load adapts to the server. Open loop (--rate N): requests are
+// scheduled at a fixed total rate regardless of how fast responses come
+// back, and latency is measured from each request's scheduled time, so a
+// stalled server shows up in the percentiles instead of silently lowering
+// the load (coordinated omission).
+
+namespace {
+    enum Action : size_t{
+        CREATE, DEPOSIT, WITHDRAW, TRANSFER, DISPLAY, ACTIONS
+    };
+    const char* const ACTION_NAMES[ACTIONS] = {"create", "deposit", "withdraw", "transfer", "display"};
+
+    // How long to wait for outstanding responses after the run ends
+    constexpr auto DRAIN_TIME = std::chrono::seconds(2);
+    constexpr size_t SETUP_BATCH = 1000;
+    const std::string HOLDER_NAME = "load";
+
+    struct Options{
+        std::string host = SERVER_IP;
+        int port = PORT;
+        int connections = 16;
+        int threads = 0; // 0 = min(connections, hardware concurrency)
+        double duration = 10;
+        double warmup = 1;
+        double rate = 0; // requests/s over all connections, 0 = closed loop
+        int pipeline = 1;
+        int accounts = 10000;
+        int firstAccount = 1000000;
+        double zipf = 0; // 0 = uniform
+        bool setup = true;
+        bool binary = false;
+        unsigned seed = 1;
+        std::string format = "text";
+        std::array<unsigned, ACTIONS> mix = {5, 35, 30, 20, 10};
+    };
+
+    void usage(const char* prog){
+        std::cerr << "Usage: " << prog << " [--host IP] [--port N] [--connections N] [--threads N]\n"
+                  << "       [--duration S] [--warmup S] [--rate N] [--pipeline N]\n"
+                  << "       [--accounts N] [--first-account N] [--zipf S] [--no-setup]\n"
+                  << "       [--mix create=5,deposit=35,withdraw=30,transfer=20,display=10]\n"
+                  << "       [--binary] [--seed N] [--format text|json]\n"
+                  << "  --connections    concurrent connections (default 16)\n"
+                  << "  --threads        client threads sharing them (default: one per connection, up to the core count)\n"
+                  << "  --duration       measured seconds (default 10), after --warmup seconds (default 1)\n"
+                  << "  --rate           open loop at N requests/s in total; without it every connection runs closed loop\n"
+                  << "  --pipeline       requests in flight per connection in closed loop (default 1)\n"
+                  << "  --accounts       accounts DEPOSIT/WITHDRAW/TRANSFER/DISPLAY pick from (default 10000),\n"
+                  << "                   numbered from --first-account (default 1000000); they are created first\n"
+                  << "                   unless --no-setup. CREATE in the mix uses numbers above that range, so on a\n"
+                  << "                   rerun against the same server those fail (counted as failed)\n"
+                  << "  --zipf           account popularity skew, 0 = uniform (default), 0.99 = typical hot set\n"
+                  << "  --mix            relative weights per action; omitted actions get 0\n"
+                  << "  --binary         negotiate the binary protocol on every connection\n";
+    }
+
+    bool parseMix(const std::string& text, std::array<unsigned, ACTIONS>& mix){
+        std::array<unsigned, ACTIONS> weights{};
+        std::stringstream ss(text);
+        std::string item;
+        while(std::getline(ss, item, ',')){
+            size_t eq = item.find('=');
+            if(eq == std::string::npos){
+                return false;
+            }
+            auto name = std::find(std::begin(ACTION_NAMES), std::end(ACTION_NAMES), item.substr(0, eq));
+            if(name == std::end(ACTION_NAMES)){
+                return false;
+            }
+            try{
+                weights[name - std::begin(ACTION_NAMES)] = static_cast<unsigned>(std::stoul(item.substr(eq + 1)));
+            }catch(const std::exception&){
+                return false;
+            }
+        }
+        mix = weights;
+        return std::any_of(mix.begin(), mix.end(), [](unsigned w){ return w > 0; });
+    }
+
+    // Account and action choice shared read-only by all workers
+    class Workload{
+    public:
+        explicit Workload(const Options& options) : options(options){
+            if(options.zipf > 0){
+                cdf.resize(options.accounts);
+                double sum = 0;
+                for(int rank = 0; rank < options.accounts; ++rank){
+                    sum += 1.0 / std::pow(rank + 1.0, options.zipf);
+                    cdf[rank] = sum;
+                }
+                for(double& c : cdf){
+                    c /= sum;
+                }
+            }
+            unsigned total = 0;
+            for(size_t a = 0; a < ACTIONS; ++a){
+                total += options.mix[a];
+                actionLimits[a] = total;
+            }
+        }
+
+        template <typename Rng>
+        Action pickAction(Rng& rng) const {
+            unsigned r = std::uniform_int_distribution<unsigned>(0, actionLimits[ACTIONS - 1] - 1)(rng);
+            return static_cast<Action>(std::upper_bound(actionLimits.begin(), actionLimits.end(), r) - actionLimits.begin());
+        }
+
+        // Rank 0 is the most popular account under zipf
+        template <typename Rng>
+        int pickAccount(Rng& rng) const {
+            if(cdf.empty()){
+                return options.firstAccount + std::uniform_int_distribution<int>(0, options.accounts - 1)(rng);
+            }
+            double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            size_t rank = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+            return options.firstAccount + static_cast<int>(std::min<size_t>(rank, cdf.size() - 1));
+        }
+
+        int newAccount() const {
+            return options.firstAccount + options.accounts + nextNew.fetch_add(1, std::memory_order_relaxed);
+        }
+    private:
+        const Options& options;
+        std::vector<double> cdf;
+        std::array<unsigned, ACTIONS> actionLimits{};
+        mutable std::atomic<int> nextNew{0};
+    };
+
+    void appendCreate(int accNum, bool binary, std::string& out){
+        bool savings = accNum % 2 == 0;
+        if(binary){
+            BinaryRequest req;
+            req.op = Opcode::CREATE;
+            req.accountType = savings ? AccountKind::SAVINGS : AccountKind::CHECKING;
+            req.accountNumber = accNum;
+            req.balance = money::fromUnits(1000000);
+            req.rateOrLimit = savings ? 10000 : 100;
+            req.holderName = HOLDER_NAME;
+            size_t frame = beginFrame(out);
+            encodeRequest(req, out);
+            endFrame(out, frame);
+            return;
+        }
+        json request = {
+            {"action", "CREATE"}, {"accountType", savings ? "SAVINGS" : "CHECKING"},
+            {"accountNumber", std::to_string(accNum)}, {"holderName", HOLDER_NAME}, {"balance", "1000000"}
+        };
+        if(savings){
+            request["interestRate"] = "0.01";
+        }else{
+            request["overdraftLimit"] = "100";
+        }
+        appendFrame(out, request.dump());
+    }
+
+    // Appends one framed request for action to out
+    template <typename Rng>
+    void appendRequest(Action action, const Workload& load, bool binary, Rng& rng, std::string& out){
+        if(action == CREATE){
+            appendCreate(load.newAccount(), binary, out);
+            return;
+        }
+
+        int accNum = load.pickAccount(rng);
+        int accNum2 = accNum;
+        if(action == TRANSFER){
+            do{
+                accNum2 = load.pickAccount(rng);
+            }while(accNum2 == accNum);
+        }
+        Money amount = std::uniform_int_distribution<Money>(1, 10000)(rng);
+
+        if(binary){
+            static const Opcode opcodes[ACTIONS] = {Opcode::CREATE, Opcode::DEPOSIT, Opcode::WITHDRAW, Opcode::TRANSFER, Opcode::DISPLAY_ONE};
+            BinaryRequest req;
+            req.op = opcodes[action];
+            req.accountNumber = accNum;
+            req.accountNumber2 = accNum2;
+            req.amount = amount;
+            size_t frame = beginFrame(out);
+            encodeRequest(req, out);
+            endFrame(out, frame);
+            return;
+        }
+
+        size_t frame = beginFrame(out);
+        switch(action){
+            case DEPOSIT:
+            case WITHDRAW:
+                out += action == DEPOSIT ? R"({"action":"DEPOSIT","accountNumber":")" : R"({"action":"WITHDRAW","accountNumber":")";
+                out += std::to_string(accNum);
+                out += R"(","amount":")";
+                out += money::toString(amount);
+                out += "\"}";
+                break;
+            case TRANSFER:
+                out += R"({"action":"TRANSFER","accountNumber1":")";
+                out += std::to_string(accNum);
+                out += R"(","accountNumber2":")";
+                out += std::to_string(accNum2);
+                out += R"(","amount":")";
+                out += money::toString(amount);
+                out += "\"}";
+                break;
+            default:
+                out += R"({"action":"DISPLAY_ONE","accountNumber":")";
+                out += std::to_string(accNum);
+                out += "\"}";
+                break;
+        }
+        endFrame(out, frame);
+    }
+
+    bool succeeded(std::string_view payload, bool binary){
+        if(binary){
+            bool success = false;
+            std::string_view message;
+            return decodeResponse(payload, success, message) && success;
+        }
+        return payload.find(R"("status":"success)") != std::string_view::npos;
+    }
+
+    int connectServer(const Options& options){
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(options.port));
+        if(inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) <= 0){
+            std::cerr << "bank_loadgen: invalid address " << options.host << "\n";
+            return -1;
+        }
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        if(sock == -1 || connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1){
+            std::perror("bank_loadgen: connect");
+            if(sock != -1){
+                close(sock);
+            }
+            return -1;
+        }
+        int noDelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if(options.binary){
+            json hello = { {"action", "HELLO"}, {"protocol", "binary"} };
+            sendMessage(sock, hello.dump());
+            if(!succeeded(recieveMessage(sock), false)){
+                std::cerr << "bank_loadgen: server refused the binary protocol\n";
+                close(sock);
+                return -1;
+            }
+        }
+        return sock;
+    }
+
+    // Creates the account range with pipelined batches over one connection
+    bool createAccounts(const Options& options){
+        int sock = connectServer(options);
+        if(sock == -1){
+            return false;
+        }
+        size_t created = 0;
+        std::string out;
+        for(int begin = 0; begin < options.accounts; begin += SETUP_BATCH){
+            int end = std::min<int>(options.accounts, begin + SETUP_BATCH);
+            out.clear();
+            for(int i = begin; i < end; ++i){
+                appendCreate(options.firstAccount + i, options.binary, out);
+            }
+            if(!sendAll(sock, out.data(), out.size())){
+                close(sock);
+                return false;
+            }
+            for(int i = begin; i < end; ++i){
+                created += succeeded(recieveMessage(sock), options.binary);
+            }
+        }
+        close(sock);
+        std::cerr << "bank_loadgen: created " << created << " of " << options.accounts
+                  << " accounts (the rest already existed)\n";
+        return true;
+    }
+
+    struct Pending{
+        Clock::time_point start;
+        Action action;
+    };
+
+    struct Connection{
+        int sock = -1;
+        FrameReader reader;
+        std::string out;
+        size_t sent = 0;
+        std::deque<Pending> inflight;
+        bool open = true;
+    };
+
+    struct WorkerStats{
+        std::array<LatencyHistogram, ACTIONS> latency;
+        std::array<uint64_t, ACTIONS> failed{};
+        uint64_t unanswered = 0;
+    };
+
+    // Sends as much of conn.out as the socket takes without blocking, so a
+    // server that stops reading cannot stall the responses we still owe it
+    // a read for
+    void flushOut(Connection& conn){
+        while(conn.open && conn.sent < conn.out.size()){
+            ssize_t n = send(conn.sock, conn.out.data() + conn.sent, conn.out.size() - conn.sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if(n > 0){
+                conn.sent += n;
+            }else if(n == -1 && errno == EINTR){
+                continue;
+            }else{
+                conn.open = n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                break;
+            }
+        }
+        if(conn.sent == conn.out.size()){
+            conn.out.clear();
+            conn.sent = 0;
+        }
+    }
+
+    struct Schedule{
+        Clock::time_point measureFrom;
+        Clock::time_point end;
+    };
+
+    void runWorker(const Options& options, const Workload& load, std::vector<Connection>& conns,
+                   const Schedule& schedule, double rate, unsigned seed, WorkerStats& stats){
+        std::mt19937_64 rng(seed);
+        bool openLoop = rate > 0;
+        auto interval = openLoop ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate))
+                                 : Clock::duration::zero();
+        Clock::time_point nextSend = Clock::now();
+        size_t nextConn = 0;
+
+        auto issue = [&](Connection& conn, Clock::time_point start){
+            Action action = load.pickAction(rng);
+            appendRequest(action, load, options.binary, rng, conn.out);
+            conn.inflight.push_back(Pending{start, action});
+        };
+
+        if(!openLoop){
+            Clock::time_point now = Clock::now();
+            for(auto& conn : conns){
+                for(int i = 0; i < options.pipeline; ++i){
+                    issue(conn, now);
+                }
+                flushOut(conn);
+            }
+        }
+
+        std::vector<pollfd> fds(conns.size());
+        while(true){
+            Clock::time_point now = Clock::now();
+            bool sending = now < schedule.end;
+            bool waiting = std::any_of(conns.begin(), conns.end(), [](const Connection& c){
+                return c.open && !c.inflight.empty();
+            });
+            if(!sending && (!waiting || now >= schedule.end + DRAIN_TIME)){
+                break;
+            }
+
+            if(openLoop && sending){
+                // catch up on every request due by now, even if the
+                // server is behind; their latency counts from the schedule
+                while(nextSend <= now){
+                    Connection& conn = conns[nextConn++ % conns.size()];
+                    if(conn.open){
+                        issue(conn, nextSend);
+                    }
+                    nextSend += interval;
+                }
+            }
+
+            for(size_t i = 0; i < conns.size(); ++i){
+                flushOut(conns[i]);
+                fds[i].fd = conns[i].open ? conns[i].sock : -1;
+                fds[i].events = POLLIN | (conns[i].out.empty() ? 0 : POLLOUT);
+                fds[i].revents = 0;
+            }
+
+            Clock::time_point wakeAt = openLoop && sending ? std::min(nextSend, schedule.end) : now + std::chrono::milliseconds(100);
+            auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(wakeAt - now, Clock::duration::zero()));
+            timespec timeout{static_cast<time_t>(wait.count() / 1000000000), static_cast<long>(wait.count() % 1000000000)};
+            if(ppoll(fds.data(), fds.size(), &timeout, nullptr) <= 0){
+                continue;
+            }
+
+            for(size_t i = 0; i < conns.size(); ++i){
+                Connection& conn = conns[i];
+                if(!(fds[i].revents & (POLLIN | POLLERR | POLLHUP))){
+                    continue;
+                }
+                ssize_t bytesRead = conn.reader.readFrom(conn.sock);
+                if(bytesRead == -1 && errno == EINTR){
+                    continue;
+                }
+                if(bytesRead <= 0){
+                    std::cerr << "bank_loadgen: server closed a connection\n";
+                    conn.open = false;
+                    continue;
+                }
+
+                Clock::time_point received = Clock::now();
+                std::string_view payload;
+                while(conn.reader.nextFrame(payload) && !conn.inflight.empty()){
+                    Pending pending = conn.inflight.front();
+                    conn.inflight.pop_front();
+                    if(pending.start >= schedule.measureFrom && pending.start < schedule.end){
+                        stats.latency[pending.action].record(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(received - pending.start).count());
+                        stats.failed[pending.action] += !succeeded(payload, options.binary);
+                    }
+                    if(!openLoop && received < schedule.end){
+                        issue(conn, received);
+                    }
+                }
+                conn.reader.compact();
+            }
+        }
+
+        for(auto& conn : conns){
+            for(const auto& pending : conn.inflight){
+                stats.unanswered += pending.start >= schedule.measureFrom && pending.start < schedule.end;
+            }
+            close(conn.sock);
+        }
+    }
+
+    json summarize(const std::string& name, const LatencyHistogram& hist, uint64_t failed, double seconds){
+        auto us = [](uint64_t ns){ return ns / 1000.0; };
+        return {
+            {"action", name},
+            {"requests", hist.count()},
+            {"failed", failed},
+            {"throughput", hist.count() / seconds},
+            {"mean_us", hist.mean() / 1000.0},
+            {"p50_us", us(hist.percentile(50))},
+            {"p99_us", us(hist.percentile(99))},
+            {"p999_us", us(hist.percentile(99.9))},
+            {"max_us", us(hist.max())}
+        };
+    }
+
+    void report(const Options& options, int threads, const std::vector<WorkerStats>& stats){
+        std::array<LatencyHistogram, ACTIONS> perAction;
+        std::array<uint64_t, ACTIONS> failed{};
+        uint64_t unanswered = 0;
+        for(const auto& worker : stats){
+            for(size_t a = 0; a < ACTIONS; ++a){
+                perAction[a].merge(worker.latency[a]);
+                failed[a] += worker.failed[a];
+            }
+            unanswered += worker.unanswered;
+        }
+        LatencyHistogram all;
+        uint64_t allFailed = 0;
+        for(size_t a = 0; a < ACTIONS; ++a){
+            all.merge(perAction[a]);
+            allFailed += failed[a];
+        }
+
+        json rows = json::array();
+        rows.push_back(summarize("all", all, allFailed, options.duration));
+        for(size_t a = 0; a < ACTIONS; ++a){
+            if(options.mix[a] > 0){
+                rows.push_back(summarize(ACTION_NAMES[a], perAction[a], failed[a], options.duration));
+            }
+        }
+
+        if(options.format == "json"){
+            json result = {
+                {"mode", options.rate > 0 ? "open" : "closed"},
+                {"rate", options.rate},
+                {"connections", options.connections},
+                {"threads", threads},
+                {"pipeline", options.pipeline},
+                {"protocol", options.binary ? "binary" : "json"},
+                {"accounts", options.accounts},
+                {"zipf", options.zipf},
+                {"duration_s", options.duration},
+                {"unanswered", unanswered},
+                {"actions", rows}
+            };
+            std::cout << result.dump() << "\n";
+            return;
+        }
+
+        std::cout << (options.rate > 0 ? "open loop at " + std::to_string(static_cast<long>(options.rate)) + " req/s" : std::string("closed loop"))
+                  << ", " << options.connections << " connections on " << threads << " threads, "
+                  << (options.binary ? "binary" : "json") << " protocol, "
+                  << options.accounts << " accounts (zipf " << options.zipf << "), "
+                  << options.duration << " s measured, " << unanswered << " unanswered\n";
+        std::cout << std::left << std::setw(10) << "action" << std::right
+                  << std::setw(12) << "requests" << std::setw(12) << "req/s" << std::setw(10) << "failed"
+                  << std::setw(10) << "mean_us" << std::setw(10) << "p50_us" << std::setw(10) << "p99_us"
+                  << std::setw(10) << "p99.9_us" << std::setw(10) << "max_us" << "\n"
+                  << std::fixed << std::setprecision(1);
+        for(const auto& row : rows){
+            std::cout << std::left << std::setw(10) << row["action"].get<std::string>() << std::right
+                      << std::setw(12) << row["requests"].get<uint64_t>()
+                      << std::setw(12) << row["throughput"].get<double>()
+                      << std::setw(10) << row["failed"].get<uint64_t>()
+                      << std::setw(10) << row["mean_us"].get<double>()
+                      << std::setw(10) << row["p50_us"].get<double>()
+                      << std::setw(10) << row["p99_us"].get<double>()
+                      << std::setw(10) << row["p999_us"].get<double>()
+                      << std::setw(10) << row["max_us"].get<double>() << "\n";
+        }
+    }
+}
+
+int main(int argc, char* argv[]){
+    Options options;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--host" && i + 1 < argc){
+            options.host = argv[++i];
+        }else if(arg == "--port" && i + 1 < argc){
+            options.port = std::atoi(argv[++i]);
+        }else if(arg == "--connections" && i + 1 < argc){
+            options.connections = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--threads" && i + 1 < argc){
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--duration" && i + 1 < argc){
+            options.duration = std::max(0.1, std::atof(argv[++i]));
+        }else if(arg == "--warmup" && i + 1 < argc){
+            options.warmup = std::max(0.0, std::atof(argv[++i]));
+        }else if(arg == "--rate" && i + 1 < argc){
+            options.rate = std::max(0.0, std::atof(argv[++i]));
+        }else if(arg == "--pipeline" && i + 1 < argc){
+            options.pipeline = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--accounts" && i + 1 < argc){
+            options.accounts = std::max(2, std::atoi(argv[++i]));
+        }else if(arg == "--first-account" && i + 1 < argc){
+            options.firstAccount = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--zipf" && i + 1 < argc){
+            options.zipf = std::max(0.0, std::atof(argv[++i]));
+        }else if(arg == "--mix" && i + 1 < argc){
+            if(!parseMix(argv[++i], options.mix)){
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }else if(arg == "--no-setup"){
+            options.setup = false;
+        }else if(arg == "--binary"){
+            options.binary = true;
+        }else if(arg == "--seed" && i + 1 < argc){
+            options.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+        }else if(arg == "--format" && i + 1 < argc){
+            options.format = argv[++i];
+            if(options.format != "text" && options.format != "json"){
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }else{
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    int threads = options.threads > 0 ? options.threads
+                                      : static_cast<int>(std::max(1u, std::min<unsigned>(options.connections, std::thread::hardware_concurrency())));
+    threads = std::min(threads, options.connections);
+
+    if(options.setup && !createAccounts(options)){
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<Connection>> groups(threads);
+    for(int i = 0; i < options.connections; ++i){
+        int sock = connectServer(options);
+        if(sock == -1){
+            return EXIT_FAILURE;
+        }
+        groups[i % threads].emplace_back().sock = sock;
+    }
+
+    Workload load(options);
+    Clock::time_point start = Clock::now();
+    Schedule schedule;
+    schedule.measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+    schedule.end = schedule.measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+    std::vector<WorkerStats> stats(threads);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        // each worker's share of the open loop rate, by its connection count
+        double rate = options.rate * groups[t].size() / options.connections;
+        workers.emplace_back(runWorker, std::cref(options), std::cref(load), std::ref(groups[t]),
+                             std::cref(schedule), rate, options.seed + t, std::ref(stats[t]));
+    }
+    for(auto& worker : workers){
+        worker.join();
+    }
+
+    report(options, threads, stats);
+    return 0;
+}
@@ -1,7 +1,13 @@
 #include "../include/Network.hpp"
 #include "../include/Bank.hpp"
+#include "../include/Metrics.hpp"
+#include "RequestHandler.hpp"
+#include "EventLoop.hpp"
 #include <iostream>
 #include <cstdlib>
+#include <csignal>
+#include <pthread.h>
+#include <cerrno>
 #include <thread>
 #include <netinet/in.h>
 #include <unistd.h>
@@ -10,69 +16,188 @@
 using json = nlohmann::json;
 
 void handleClient(int clientSocket){
-    while(true){
-        std::string request = recieveMessage(clientSocket);
-        
-        if(request.empty()){
-            break;
-        }
-
-        json reqJson;
-        json response;
+    FrameReader reader;
+    Session session;
+    std::string out;
+    Metrics::getInstance().connectionOpened();
 
-        try{
-            reqJson = json::parse(request);
-        }catch(const json::parse_error& e){
-            response["status"] = "failed: ";
-            response["message"] = "Invalid JSON format\n";
-            sendMessage(clientSocket, response.dump());
+    while(!session.closing){
+        ssize_t bytesRead = reader.readFrom(clientSocket);
+        if(bytesRead == -1 && errno == EINTR){
             continue;
         }
+        if(bytesRead <= 0){
+            break;
+        }
 
-        std::string action = reqJson["action"];
-
-        if(action == "CREATE"){
-            response = Bank::getInstance().createAccountFromJson(reqJson);
-        }else if(action == "DELETE"){
-            response = Bank::getInstance().closeAccount(reqJson);
-        }else if(action == "MODIFY"){
-            response = Bank::getInstance().modifyAccount(reqJson);
-        }else if(action == "DEPOSIT"){
-            response = Bank::getInstance().deposit(reqJson);
-        }else if(action == "WITHDRAW"){
-            response = Bank::getInstance().withdraw(reqJson);
-        }else if(action == "TRANSFER"){
-            response = Bank::getInstance().transfer(reqJson);
-        }else if(action == "APPLY_INTEREST_ONE"){
-            response = Bank::getInstance().applyInterestOne(reqJson);
-        }else if(action == "APPLY_INTEREST_ALL"){
-            response = Bank::getInstance().applyInterestAll(reqJson);
-        }else if(action == "DISPLAY_ONE"){
-            response = Bank::getInstance().displayAccount(reqJson);
-        }else if(action == "DISPLAY_ALL"){
-            response = Bank::getInstance().displayAllAccounts();
-        }else if(action == "DELETE_ALL"){
-            response = Bank::getInstance().deleteAllAccounts();
-        }else if(action == "EXPORT_JSON"){
-            response = Bank::getInstance().exportAllAccountsToFile();
-        }else if(action == "EXIT"){
-            response["status"] = "success: ";
-            response["message"] = "Closing Bank";
-            sendMessage(clientSocket, response.dump());
+        // answer every pipelined request received so far, then send all the
+        // responses with one write
+        std::string_view request;
+        while(!session.closing && reader.nextFrame(request)){
+            handleFrame(session, request, out);
+        }
+        if(reader.oversized()){
             break;
-        }else{
-            response["status"] = "failed: ";
-            response["message"] = "Invalid action!"; 
         }
 
-        sendMessage(clientSocket, response.dump());
+        if(!out.empty()){
+            if(!sendAll(clientSocket, out.data(), out.size())){
+                break;
+            }
+            out.clear();
+        }
     }
 
     close(clientSocket);
+    Metrics::getInstance().connectionClosed();
     std::cout << "[Server] Client disconnected.\n";
 }
 
-int main(){
+void usage(const char* prog){
+    std::cerr << "Usage: " << prog << " [--mode threads|epoll] [--io-threads N] [--workers N]\n"
+              << "       [--flush-interval-ms N] [--flush-batch N]\n"
+              << "       [--journal PATH] [--fsync none|group|always] [--group-commit-us N]\n"
+              << "       [--snapshot PATH] [--snapshot-interval-s N]\n"
+              << "       [--redis-host HOST] [--redis-port N] [--redis-pool N]\n"
+              << "       [--redis-connect-timeout-ms N] [--redis-timeout-ms N] [--redis-keepalive on|off]\n"
+              << "       [--metrics-file PATH] [--metrics-interval-s N]\n"
+              << "       [--cache-mb N] [--export-dir DIR] [--export-jobs N]\n"
+              << "  threads  one thread per connection (default)\n"
+              << "  epoll    event loop with N I/O threads (default: hardware concurrency)\n"
+              << "  --workers          epoll: threads for mutations and requests that may block, e.g. DELETE_ALL,\n"
+              << "                     and for every request under --cache-mb (default: hardware concurrency)\n"
+              << "  --flush-interval-ms / --flush-batch  write-behind flush cadence (default 50 ms / 1000 accounts)\n"
+              << "  --journal          write-ahead journal file (default bank.journal)\n"
+              << "  --fsync            journal durability: none, group commit (default) or one fsync per op\n"
+              << "  --group-commit-us  how long a group commit leader waits for followers (default 0)\n"
+              << "  --snapshot         binary snapshot file, loaded at startup in place of Redis when usable (default bank.snapshot)\n"
+              << "  --snapshot-interval-s  background snapshot period, 0 to disable (default 300)\n"
+              << "  --redis-host / --redis-port  Redis server (default 127.0.0.1:6379)\n"
+              << "  --redis-pool       Redis connections shared by all threads (default 4)\n"
+              << "  --redis-connect-timeout-ms / --redis-timeout-ms  connect and per-command timeouts, 0 waits forever (default 1000 / 0)\n"
+              << "  --redis-keepalive  TCP keepalive on Redis connections (default on)\n"
+              << "  --metrics-file     Prometheus text file with the STATS counters and latencies (default bank_metrics.prom)\n"
+              << "  --metrics-interval-s  how often it is rewritten, 0 to disable (default 10)\n"
+              << "  --export-dir       directory EXPORT_JSON paths are resolved under (default exports)\n"
+              << "  --export-jobs      exports allowed to run at once (default 2)\n"
+              << "  --cache-mb         keep only a hot set of about N MB of accounts in memory and load the rest from\n"
+              << "                     Redis on demand; disables snapshots, DISPLAY_ALL and EXPORT_JSON (default 0: whole table)\n";
+}
+
+// Waits for SIGINT/SIGTERM, which main() blocks in every thread, and flushes
+// queued Redis writes before exiting.
+void shutdownOnSignal(sigset_t signals){
+    int sig = 0;
+    sigwait(&signals, &sig);
+    std::cout << "[Server] Shutting down, flushing pending writes...\n";
+    WriteBehindQueue::getInstance().stop();
+    std::cout.flush();
+    // skip static destructors: detached client threads may still hold the Bank
+    std::_Exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char* argv[]){
+    std::string mode = "threads";
+    int ioThreads = std::max(1u, std::thread::hardware_concurrency());
+    int workerThreads = ioThreads;
+    WriteBehindConfig flushConfig;
+    JournalConfig journalConfig;
+    std::string snapshotPath = "bank.snapshot";
+    int snapshotInterval = 300;
+    RedisConfig redisConfig;
+    std::string metricsPath = "bank_metrics.prom";
+    int metricsInterval = 10;
+    ExportConfig exportConfig;
+    size_t cacheMb = 0;
+
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--mode" && i + 1 < argc){
+            mode = argv[++i];
+        }else if(arg == "--io-threads" && i + 1 < argc){
+            ioThreads = std::atoi(argv[++i]);
+        }else if(arg == "--workers" && i + 1 < argc){
+            workerThreads = std::atoi(argv[++i]);
+        }else if(arg == "--flush-interval-ms" && i + 1 < argc){
+            flushConfig.flushInterval = std::chrono::milliseconds(std::atoi(argv[++i]));
+        }else if(arg == "--flush-batch" && i + 1 < argc){
+            flushConfig.maxBatch = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--journal" && i + 1 < argc){
+            journalConfig.path = argv[++i];
+        }else if(arg == "--fsync" && i + 1 < argc){
+            std::string policy = argv[++i];
+            if(policy == "none"){
+                journalConfig.policy = FsyncPolicy::NONE;
+            }else if(policy == "group"){
+                journalConfig.policy = FsyncPolicy::GROUP;
+            }else if(policy == "always"){
+                journalConfig.policy = FsyncPolicy::ALWAYS;
+            }else{
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }else if(arg == "--group-commit-us" && i + 1 < argc){
+            journalConfig.groupDelay = std::chrono::microseconds(std::atoi(argv[++i]));
+        }else if(arg == "--snapshot" && i + 1 < argc){
+            snapshotPath = argv[++i];
+        }else if(arg == "--snapshot-interval-s" && i + 1 < argc){
+            snapshotInterval = std::atoi(argv[++i]);
+        }else if(arg == "--redis-host" && i + 1 < argc){
+            redisConfig.host = argv[++i];
+        }else if(arg == "--redis-port" && i + 1 < argc){
+            redisConfig.port = std::atoi(argv[++i]);
+        }else if(arg == "--redis-pool" && i + 1 < argc){
+            redisConfig.poolSize = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--redis-connect-timeout-ms" && i + 1 < argc){
+            redisConfig.connectTimeout = std::chrono::milliseconds(std::max(0, std::atoi(argv[++i])));
+        }else if(arg == "--redis-timeout-ms" && i + 1 < argc){
+            redisConfig.socketTimeout = std::chrono::milliseconds(std::max(0, std::atoi(argv[++i])));
+        }else if(arg == "--redis-keepalive" && i + 1 < argc){
+            std::string keepAlive = argv[++i];
+            if(keepAlive != "on" && keepAlive != "off"){
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            redisConfig.keepAlive = keepAlive == "on";
+        }else if(arg == "--metrics-file" && i + 1 < argc){
+            metricsPath = argv[++i];
+        }else if(arg == "--metrics-interval-s" && i + 1 < argc){
+            metricsInterval = std::atoi(argv[++i]);
+        }else if(arg == "--export-dir" && i + 1 < argc){
+            exportConfig.directory = argv[++i];
+        }else if(arg == "--export-jobs" && i + 1 < argc){
+            exportConfig.maxRunning = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "--cache-mb" && i + 1 < argc){
+            cacheMb = std::max(0, std::atoi(argv[++i]));
+        }else{
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if((mode != "threads" && mode != "epoll") || ioThreads < 1 || workerThreads < 1){
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // a client hanging up mid-response must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // block shutdown signals before any thread starts so only the shutdown
+    // thread receives them
+    sigset_t shutdownSignals;
+    sigemptyset(&shutdownSignals);
+    sigaddset(&shutdownSignals, SIGINT);
+    sigaddset(&shutdownSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdownSignals, nullptr);
+    std::thread(shutdownOnSignal, shutdownSignals).detach();
+
+    RedisCache::configure(redisConfig);
+    WriteBehindQueue::getInstance().configure(flushConfig);
+    AccountExporter::getInstance().configure(exportConfig);
+    if(!Journal::getInstance().open(journalConfig)){
+        exit(EXIT_FAILURE);
+    }
 
     int server_fd, client_fd;
     struct sockaddr_in address;
@@ -100,20 +225,41 @@ int main(){
         exit(EXIT_FAILURE);
     }
 
-    if(listen(server_fd, 10) == -1){
+    if(listen(server_fd, SOMAXCONN) == -1){
         std::perror("listen");
         exit(EXIT_FAILURE);
     }
 
-    std::cout << "[Server] listening on port " << PORT << "...\n";
-    Bank::getInstance().loadAllAccounts();
+    std::cout << "[Server] listening on port " << PORT << " (" << mode << " mode)...\n";
+    Bank::getInstance().configureHotSet(cacheMb * 1024 * 1024 / Bank::HOT_SET_ACCOUNT_BYTES);
+    Bank::getInstance().configureSnapshots(snapshotPath, std::chrono::seconds(snapshotInterval));
+    json loadResult = Bank::getInstance().loadAllAccounts();
+    if(loadResult["status"] != "success: "){
+        std::cerr << "[Server] " << loadResult["message"].get<std::string>() << "\n";
+        exit(EXIT_FAILURE);
+    }
+    Metrics::getInstance().startExporter(metricsPath, std::chrono::seconds(metricsInterval));
+
+    if(mode == "epoll"){
+        // a Redis load would hold up every connection on the loop, so in
+        // hot-set mode no request runs there. A mutation's journal commit
+        // (an fdatasync unless --fsync none) or the checkpoint it may start
+        // (a flush to Redis, in every mode) would too, so none does
+        Offload offload = cacheMb > 0 ? Offload::ALL : Offload::MUTATIONS;
+        runEventLoopServer(server_fd, ioThreads, workerThreads, offload);
+        return 0;
+    }
 
     while(true){
         client_fd = accept(server_fd, (struct sockaddr*)&address, (socklen_t*)&addrlen);
+        if(client_fd == -1){
+            std::perror("accept");
+            continue;
+        }
         std::cout << "[Server] New client connected.\n";
         std::thread clientThread(handleClient, client_fd);
         clientThread.detach();
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,387 @@
+#include "EventLoop.hpp"
+#include "RequestHandler.hpp"
+#include "../include/Network.hpp"
+#include "../include/Metrics.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+namespace {
+    constexpr int MAX_EVENTS = 256;
+    // unsent responses past which a connection's requests wait (and its
+    // socket is not read) until the client reads some of them
+    constexpr size_t MAX_OUT_BACKLOG = MAX_FRAME_SIZE;
+
+    struct Connection{
+        int fd;
+        FrameReader in;  // bytes received but not yet handled
+        std::string out; // responses not yet written
+        size_t outPos = 0;
+        Session session; // protocol state; close once out is drained after EXIT
+        uint32_t events = EPOLLIN; // what epoll currently watches for
+        bool busy = false; // handed to a worker, which owns in/out/session until it is done
+
+        size_t backlog() const { return out.size() - outPos; }
+    };
+
+    bool setNonBlocking(int fd){
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+
+    // Runs the requests that may block, shared by every loop
+    class WorkerPool{
+    public:
+        explicit WorkerPool(int threads){
+            for(int i = 0; i < threads; ++i){
+                workers.emplace_back([this]{ work(); });
+            }
+        }
+
+        ~WorkerPool(){
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            ready.notify_all();
+            for(auto& worker : workers){
+                worker.join();
+            }
+        }
+
+        void submit(std::function<void()> task){
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                tasks.push_back(std::move(task));
+            }
+            ready.notify_one();
+        }
+    private:
+        void work(){
+            while(true){
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    ready.wait(lock, [this]{ return stopping || !tasks.empty(); });
+                    if(tasks.empty()){
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::mutex mtx;
+        std::condition_variable ready;
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+    };
+
+    class EventLoop{
+    public:
+        EventLoop(int listenFd, WorkerPool& workers, Offload offload) : listenFd(listenFd), workers(workers), offload(offload) {}
+
+        void run(){
+            epollFd = epoll_create1(0);
+            if(epollFd == -1){
+                std::perror("epoll_create1");
+                return;
+            }
+
+            // workers report finished hand-offs through this
+            wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            epoll_event wake{};
+            wake.events = EPOLLIN;
+            wake.data.fd = wakeFd;
+            if(wakeFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wake) == -1){
+                std::perror("eventfd");
+                return;
+            }
+
+            // EPOLLEXCLUSIVE wakes only one loop per incoming connection
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+            ev.data.fd = listenFd;
+            if(epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) == -1){
+                std::perror("epoll_ctl");
+                return;
+            }
+
+            epoll_event events[MAX_EVENTS];
+            while(true){
+                int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+                if(n == -1){
+                    if(errno == EINTR){
+                        continue;
+                    }
+                    std::perror("epoll_wait");
+                    return;
+                }
+
+                for(int i = 0; i < n; ++i){
+                    int fd = events[i].data.fd;
+                    if(fd == listenFd){
+                        acceptClients();
+                        continue;
+                    }
+                    if(fd == wakeFd){
+                        finishHandOffs();
+                        continue;
+                    }
+
+                    auto it = connections.find(fd);
+                    if(it == connections.end() || it->second.busy){
+                        continue;
+                    }
+
+                    Connection& conn = it->second;
+                    bool alive = true;
+                    if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)){
+                        alive = readRequests(conn);
+                    }
+                    if(alive && !conn.busy && (events[i].events & EPOLLOUT)){
+                        alive = handleRequests(conn); // requests held back by the backlog, then the rest of out
+                    }
+                    if(!alive){
+                        closeConnection(fd);
+                    }
+                }
+            }
+        }
+    private:
+        void acceptClients(){
+            while(true){
+                int clientFd = accept(listenFd, nullptr, nullptr);
+                if(clientFd == -1){
+                    if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                        std::perror("accept");
+                    }
+                    return;
+                }
+
+                if(!setNonBlocking(clientFd)){
+                    close(clientFd);
+                    continue;
+                }
+
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.fd = clientFd;
+                if(epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &ev) == -1){
+                    std::perror("epoll_ctl");
+                    close(clientFd);
+                    continue;
+                }
+
+                connections[clientFd].fd = clientFd;
+                Metrics::getInstance().connectionOpened();
+                std::cout << "[Server] New client connected.\n";
+            }
+        }
+
+        // Reads until the socket is drained or a full frame's worth is
+        // buffered, answers the complete requests and returns false when
+        // the connection should be closed. Whatever is left in the socket
+        // comes back on the next (level-triggered) wait, after the other
+        // connections had their turn.
+        bool readRequests(Connection& conn){
+            while(conn.in.buffered() < FRAME_HEADER_SIZE + MAX_FRAME_SIZE){
+                ssize_t bytesRead = conn.in.readFrom(conn.fd);
+                if(bytesRead > 0){
+                    continue;
+                }
+                if(bytesRead == 0){
+                    return false;
+                }
+                if(errno == EINTR){
+                    continue;
+                }
+                if(errno == EAGAIN || errno == EWOULDBLOCK){
+                    break;
+                }
+                return false;
+            }
+            return handleRequests(conn);
+        }
+
+        // Answers the complete requests in conn.in and sends the responses.
+        // Pipelined requests are answered back to back and their responses
+        // coalesced into one send; once the unsent backlog passes
+        // MAX_OUT_BACKLOG the rest wait until the client has read enough.
+        bool handleRequests(Connection& conn){
+            while(true){
+                std::string_view request;
+                while(!conn.session.closing && conn.backlog() <= MAX_OUT_BACKLOG && conn.in.nextFrame(request)){
+                    if(offload == Offload::ALL || isBlockingRequest(conn.session, request)){
+                        return handOff(conn, request);
+                    }
+                    handleFrame(conn.session, request, conn.out);
+                }
+                if(conn.in.oversized()){
+                    return false;
+                }
+
+                bool heldBack = conn.backlog() > MAX_OUT_BACKLOG;
+                if(!flushResponses(conn)){
+                    return false;
+                }
+                // sent enough to make room for the requests held back
+                if(!heldBack || conn.session.closing || conn.backlog() > MAX_OUT_BACKLOG){
+                    return true;
+                }
+            }
+        }
+
+        // Takes the connection off this loop while a worker answers request
+        // and every other complete one buffered after it, in order; the
+        // loop does not touch it again until finishHandOffs. request points
+        // into conn.in, which nothing reads into meanwhile.
+        bool handOff(Connection& conn, std::string_view request){
+            if(epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.fd, nullptr) == -1){
+                return false;
+            }
+            conn.events = 0;
+            conn.busy = true;
+            Connection* handed = &conn; // map nodes do not move
+            workers.submit([this, handed, request]{
+                handleFrame(handed->session, request, handed->out);
+                std::string_view next;
+                while(!handed->session.closing && handed->backlog() <= MAX_OUT_BACKLOG && handed->in.nextFrame(next)){
+                    handleFrame(handed->session, next, handed->out);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(doneMtx);
+                    done.push_back(handed->fd);
+                }
+                uint64_t one = 1;
+                ssize_t written = write(wakeFd, &one, sizeof(one));
+                (void)written; // only fails if the counter would overflow
+            });
+            return true;
+        }
+
+        // Puts connections back on the loop once their worker is done and
+        // sends what it answered
+        void finishHandOffs(){
+            uint64_t count;
+            ssize_t got = read(wakeFd, &count, sizeof(count));
+            (void)got;
+
+            std::vector<int> finished;
+            {
+                std::lock_guard<std::mutex> lock(doneMtx);
+                finished.swap(done);
+            }
+            for(int fd : finished){
+                Connection& conn = connections.at(fd);
+                conn.busy = false;
+                bool alive = !conn.in.oversized();
+                if(alive){
+                    epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = fd;
+                    alive = epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != -1;
+                    conn.events = EPOLLIN;
+                }
+                if(alive){
+                    alive = handleRequests(conn); // whatever the backlog held back, then the responses
+                }
+                if(!alive){
+                    closeConnection(fd);
+                }
+            }
+        }
+
+        bool flushResponses(Connection& conn){
+            while(conn.outPos < conn.out.size()){
+                ssize_t sent = send(conn.fd, conn.out.data() + conn.outPos, conn.out.size() - conn.outPos, MSG_NOSIGNAL);
+                if(sent > 0){
+                    conn.outPos += sent;
+                    continue;
+                }
+                if(sent == -1 && errno == EINTR){
+                    continue;
+                }
+                if(sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+                    // socket buffer full: wait for EPOLLOUT, and over the
+                    // backlog cap stop reading as well. The sent prefix is
+                    // dropped once it outweighs the rest, so the moves stay
+                    // linear in what is sent
+                    if(conn.outPos >= conn.backlog()){
+                        conn.out.erase(0, conn.outPos);
+                        conn.outPos = 0;
+                    }
+                    return watch(conn, conn.backlog() > MAX_OUT_BACKLOG ? EPOLLOUT : EPOLLIN | EPOLLOUT);
+                }
+                return false;
+            }
+
+            conn.out.clear();
+            conn.outPos = 0;
+            return !conn.session.closing && watch(conn, EPOLLIN);
+        }
+
+        bool watch(Connection& conn, uint32_t events){
+            if(conn.events == events){
+                return true;
+            }
+            conn.events = events;
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = conn.fd;
+            return epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev) != -1;
+        }
+
+        void closeConnection(int fd){
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            connections.erase(fd);
+            Metrics::getInstance().connectionClosed();
+            std::cout << "[Server] Client disconnected.\n";
+        }
+
+        int listenFd;
+        int epollFd = -1;
+        int wakeFd = -1;
+        WorkerPool& workers;
+        Offload offload;
+        std::unordered_map<int, Connection> connections;
+        std::mutex doneMtx;
+        std::vector<int> done; // fds whose hand-off finished, for finishHandOffs
+    };
+}
+
+void runEventLoopServer(int serverFd, int ioThreads, int workerThreads, Offload offload){
+    if(!setNonBlocking(serverFd)){
+        std::perror("fcntl");
+        return;
+    }
+
+    WorkerPool workers(workerThreads);
+    std::vector<std::thread> loops;
+    for(int i = 0; i < ioThreads; ++i){
+        loops.emplace_back([serverFd, &workers, offload]{
+            EventLoop loop(serverFd, workers, offload);
+            loop.run();
+        });
+    }
+    for(auto& loop : loops){
+        loop.join();
+    }
+}
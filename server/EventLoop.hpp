@@ -0,0 +1,15 @@
+#pragma once
+
+// Event-driven server mode: each I/O thread runs its own epoll loop over
+// non-blocking sockets and accepts from the shared listening socket, so
+// thousands of mostly idle connections cost a buffer each instead of a thread.
+//
+// Requests are answered on the loop thread, except those that may block it
+// (isBlockingRequest), which go to a pool of workerThreads along with the
+// rest of their connection's buffered requests.
+enum class Offload{
+    MUTATIONS, // every request that journals (commit, checkpoint) or may block
+    ALL        // every request, e.g. when any lookup may load from Redis
+};
+
+void runEventLoopServer(int serverFd, int ioThreads, int workerThreads, Offload offload);
@@ -0,0 +1,417 @@
+#include "RequestHandler.hpp"
+#include "../include/Bank.hpp"
+#include "../include/BinaryProtocol.hpp"
+#include "../include/Network.hpp"
+#include "../include/RequestDecoder.hpp"
+#include "../include/Metrics.hpp"
+
+// What handleFrame records for a request
+struct Outcome{
+    RequestKind kind = RequestKind::INVALID;
+    bool ok = false;
+};
+
+static json dispatch(Session& session, const json& reqJson, RequestKind& kind){
+    json response;
+    std::string action = reqJson.at("action");
+    kind = requestKindFromName(action);
+
+    if(action == "CREATE"){
+        response = Bank::getInstance().createAccountFromJson(reqJson);
+    }else if(action == "DELETE"){
+        response = Bank::getInstance().closeAccount(reqJson);
+    }else if(action == "MODIFY"){
+        response = Bank::getInstance().modifyAccount(reqJson);
+    }else if(action == "DEPOSIT"){
+        response = Bank::getInstance().deposit(reqJson);
+    }else if(action == "WITHDRAW"){
+        response = Bank::getInstance().withdraw(reqJson);
+    }else if(action == "TRANSFER"){
+        response = Bank::getInstance().transfer(reqJson);
+    }else if(action == "BATCH"){
+        response = Bank::getInstance().batch(reqJson);
+    }else if(action == "TRANSFER_BATCH"){
+        response = Bank::getInstance().transferBatch(reqJson);
+    }else if(action == "APPLY_INTEREST_ONE"){
+        response = Bank::getInstance().applyInterestOne(reqJson);
+    }else if(action == "APPLY_INTEREST_ALL"){
+        response = Bank::getInstance().applyInterestAll(reqJson);
+    }else if(action == "DISPLAY_ONE"){
+        response = Bank::getInstance().displayAccount(reqJson);
+    }else if(action == "DISPLAY_ALL"){
+        response = Bank::getInstance().displayAllAccounts(reqJson);
+    }else if(action == "DELETE_ALL"){
+        response = Bank::getInstance().deleteAllAccounts();
+    }else if(action == "EXPORT_JSON"){
+        response = Bank::getInstance().exportAllAccountsToFile(reqJson);
+    }else if(action == "EXPORT_STATUS"){
+        response = Bank::getInstance().exportStatus(reqJson);
+    }else if(action == "SNAPSHOT"){
+        response = Bank::getInstance().writeSnapshot();
+    }else if(action == "EXIT"){
+        response["status"] = "success: ";
+        response["message"] = "Closing Bank";
+        session.closing = true;
+    }else if(action == "STATS"){
+        response["status"] = "success: ";
+        response["message"] = "Server statistics";
+        response["persistence"] = WriteBehindQueue::getInstance().stats();
+        response["journal"] = Journal::getInstance().stats();
+        response.update(Metrics::getInstance().stats());
+        if(!Bank::getInstance().wholeTableInMemory()){
+            response["cache"] = Bank::getInstance().cacheStats();
+        }
+    }else if(action == "HELLO"){
+        std::string protocol = reqJson.value("protocol", "json");
+        if(protocol == "binary"){
+            session.binary = true;
+            response["status"] = "success: ";
+            response["message"] = "Binary protocol enabled";
+        }else if(protocol == "json"){
+            response["status"] = "success: ";
+            response["message"] = "JSON protocol enabled";
+        }else{
+            response["status"] = "failed: ";
+            response["message"] = "Unknown protocol '" + protocol + "'";
+        }
+    }else{
+        response["status"] = "failed: ";
+        response["message"] = "Invalid action!"; 
+    }
+
+    return response;
+}
+
+static json handleJsonRequest(Session& session, const std::string& request, RequestKind& kind){
+    json reqJson;
+    json response;
+
+    try{
+        reqJson = json::parse(request);
+    }catch(const json::parse_error& e){
+        response["status"] = "failed: ";
+        response["message"] = "Invalid JSON format\n";
+        return response;
+    }
+
+    try{
+        response = dispatch(session, reqJson, kind);
+    }catch(const json::exception& e){
+        // e.g. a missing action or a number where a string field was expected
+        response["status"] = "failed: ";
+        response["message"] = "Invalid request format";
+    }
+
+    return response;
+}
+
+json handleRequest(Session& session, const std::string& request){
+    RequestKind kind = RequestKind::INVALID;
+    return handleJsonRequest(session, request, kind);
+}
+
+static bool succeeded(const json& response){
+    auto status = response.find("status");
+    return status != response.end() && status->is_string() &&
+           status->get_ref<const std::string&>().compare(0, 7, "success") == 0;
+}
+
+static RequestKind kindOf(Opcode op){
+    switch(op){
+        case Opcode::CREATE: return RequestKind::CREATE;
+        case Opcode::DELETE: return RequestKind::DELETE;
+        case Opcode::MODIFY: return RequestKind::MODIFY;
+        case Opcode::DEPOSIT: return RequestKind::DEPOSIT;
+        case Opcode::WITHDRAW: return RequestKind::WITHDRAW;
+        case Opcode::TRANSFER: return RequestKind::TRANSFER;
+        case Opcode::APPLY_INTEREST_ONE: return RequestKind::APPLY_INTEREST_ONE;
+        case Opcode::APPLY_INTEREST_ALL: return RequestKind::APPLY_INTEREST_ALL;
+        case Opcode::DISPLAY_ONE: return RequestKind::DISPLAY_ONE;
+        case Opcode::DISPLAY_ALL: return RequestKind::DISPLAY_ALL;
+        case Opcode::DELETE_ALL: return RequestKind::DELETE_ALL;
+        case Opcode::EXPORT_JSON: return RequestKind::EXPORT_JSON;
+        case Opcode::EXIT: return RequestKind::EXIT;
+    }
+    return RequestKind::INVALID;
+}
+
+// rateOrLimit becomes an int overdraft limit for checking accounts; the JSON
+// path range checks that field the same way
+static bool overdraftInRange(int64_t rateOrLimit, json& response){
+    if(rateOrLimit < std::numeric_limits<int>::min() || rateOrLimit > std::numeric_limits<int>::max()){
+        response["status"] = "failed: ";
+        response["message"] = fields::message(fields::Error::INT_RANGE, "overdraftLimit");
+        return false;
+    }
+    return true;
+}
+
+// the JSON path limits amounts and rates as it parses them; binary values
+// arrive decoded, so they are checked here
+static bool amountInRange(Money amount, std::string_view key, json& response){
+    if(!fields::amountInRange(amount)){
+        response["status"] = "failed: ";
+        response["message"] = fields::message(fields::Error::AMOUNT_RANGE, key);
+        return false;
+    }
+    return true;
+}
+
+static void handleBinaryRequest(Session& session, std::string_view payload, std::string& out, Outcome& outcome){
+    BinaryRequest req;
+    // responses are encoded straight into out, framed in place
+    size_t frame = beginFrame(out);
+
+    if(!decodeRequest(payload, req)){
+        encodeResponse(false, "Invalid binary request", out);
+        endFrame(out, frame);
+        return;
+    }
+
+    Bank& bank = Bank::getInstance();
+    json response;
+    outcome.kind = kindOf(req.op);
+
+    switch(req.op){
+        case Opcode::DEPOSIT:
+        case Opcode::WITHDRAW: {
+            // the hot path: no json, no strings, nothing on the heap
+            bool deposit = req.op == Opcode::DEPOSIT;
+            if(!fields::amountInRange(req.amount)){
+                encodeResponse(false, fields::message(fields::Error::AMOUNT_RANGE, "amount"), out);
+                endFrame(out, frame);
+                return;
+            }
+            BalanceResult result = deposit ? bank.depositBalance(req.accountNumber, req.amount)
+                                           : bank.withdrawBalance(req.accountNumber, req.amount);
+            char text[Bank::BALANCE_MESSAGE_MAX];
+            outcome.ok = result.code == BalanceResult::OK;
+            encodeResponse(outcome.ok, Bank::balanceMessage(result, deposit, req.accountNumber, text), out);
+            endFrame(out, frame);
+            return;
+        }
+        case Opcode::CREATE: {
+            if(!amountInRange(req.balance, "balance", response)){
+                break;
+            }
+            if(req.accountType == AccountKind::CHECKING && !overdraftInRange(req.rateOrLimit, response)){
+                break;
+            }
+            if(req.accountType == AccountKind::SAVINGS && !fields::rateInRange(req.rateOrLimit)){
+                response["status"] = "failed: ";
+                response["message"] = fields::message(fields::Error::RATE_RANGE, "interestRate");
+                break;
+            }
+            response = bank.createAccount(static_cast<AccountType>(req.accountType), req.accountNumber, std::string(req.holderName), req.balance,
+                                          req.rateOrLimit, static_cast<int>(req.rateOrLimit));
+            break;
+        }
+        case Opcode::DELETE:
+            response = bank.closeAccount(req.accountNumber);
+            break;
+        case Opcode::MODIFY:
+            // the account type is not in the request, so the value has to
+            // work as either field; Bank range checks it as a rate
+            if(!amountInRange(req.balance, "balance", response) || !overdraftInRange(req.rateOrLimit, response)){
+                break;
+            }
+            // an empty name is the binary form of the "0" that leaves it unchanged
+            response = bank.modifyAccount(req.accountNumber, req.holderName.empty() ? std::string("0") : std::string(req.holderName),
+                                          req.balance, req.rateOrLimit, static_cast<int>(req.rateOrLimit));
+            break;
+        case Opcode::TRANSFER:
+            if(!amountInRange(req.amount, "amount", response)){
+                break;
+            }
+            response = bank.transfer(req.accountNumber, req.accountNumber2, req.amount);
+            break;
+        case Opcode::APPLY_INTEREST_ONE:
+            response = bank.applyInterestOne(req.accountNumber);
+            break;
+        case Opcode::APPLY_INTEREST_ALL:
+            response = bank.applyInterestAll(json::object());
+            break;
+        case Opcode::DISPLAY_ONE:
+            response = bank.displayAccount(req.accountNumber);
+            break;
+        case Opcode::DISPLAY_ALL: {
+            if(!bank.wholeTableInMemory()){
+                response = bank.displayAllAccounts(json::object()); // says why not
+                break;
+            }
+            std::optional<AccountType> type;
+            if(req.accountType != AccountKind::ANY){
+                type = static_cast<AccountType>(req.accountType);
+            }
+            size_t limit = req.limit == 0 ? Bank::DEFAULT_PAGE_SIZE : std::min<size_t>(req.limit, Bank::MAX_PAGE_SIZE);
+
+            AccountPage page;
+            if(!bank.listAccounts(req.cursor, limit, type, page)){
+                encodeResponse(false, "Invalid cursor.", out);
+                endFrame(out, frame);
+                return;
+            }
+
+            std::vector<BinaryAccount> list;
+            list.reserve(page.accounts.size());
+            for(auto& image : page.accounts){
+                list.push_back({static_cast<AccountKind>(image.type), image.accountNumber,
+                                image.balance, image.rateOrLimit, std::move(image.holderName)});
+            }
+            encodeAccountList(list, page.nextCursor, out);
+            endFrame(out, frame);
+            outcome.ok = true;
+            return;
+        }
+        case Opcode::DELETE_ALL:
+            response = bank.deleteAllAccounts();
+            break;
+        case Opcode::EXPORT_JSON:
+            response = bank.exportAllAccountsToFile();
+            break;
+        case Opcode::EXIT:
+            response["status"] = "success: ";
+            response["message"] = "Closing Bank";
+            session.closing = true;
+            break;
+    }
+
+    outcome.ok = succeeded(response);
+    encodeResponse(outcome.ok, response["message"].get_ref<const std::string&>(), out);
+    endFrame(out, frame);
+}
+
+// Reads one string field of a decoded request the way validateJsonField
+// reads it from a DOM, failing with the same message
+template <typename T>
+static bool decodedField(const RequestDecoder& decoder, std::string_view key, T& out, json& response){
+    const RequestDecoder::Field* field = decoder.find(key);
+    fields::Error error = fields::Error::OK;
+    if(field == nullptr){
+        error = fields::Error::MISSING;
+    }else if(field->kind != RequestDecoder::Kind::STRING){
+        error = fields::Error::NOT_A_STRING;
+    }else if constexpr (std::is_same_v<T, int>){
+        error = fields::parseInt(field->value, out);
+    }else{
+        error = fields::parseAmount(field->value, out);
+    }
+
+    if(error != fields::Error::OK){
+        response["status"] = "failed: ";
+        response["message"] = fields::message(error, key);
+        return false;
+    }
+    return true;
+}
+
+// DEPOSIT/WITHDRAW reply, byte for byte what json::dump gives for
+// {"status", "message"} (keys sorted) without building the object
+static void appendBalanceResponse(const BalanceResult& result, bool deposit, int accNum, std::string& out){
+    char text[Bank::BALANCE_MESSAGE_MAX];
+    size_t frame = beginFrame(out);
+    out += "{\"message\":\"";
+    out += Bank::balanceMessage(result, deposit, accNum, text);
+    out += result.code == BalanceResult::OK ? "\",\"status\":\"success: \"}" : "\",\"status\":\"failed: \"}";
+    endFrame(out, frame);
+}
+
+// The common single-account actions, decoded in one pass with no DOM. Returns
+// false, having written nothing, for anything else; handleRequest takes those.
+static bool handleDecodedRequest(std::string_view payload, std::string& out, Outcome& outcome){
+    RequestDecoder decoder;
+    if(!decoder.parse(payload)){
+        return false;
+    }
+    const RequestDecoder::Field* action = decoder.find("action");
+    if(action == nullptr || action->kind != RequestDecoder::Kind::STRING){
+        return false;
+    }
+
+    Bank& bank = Bank::getInstance();
+    json response;
+    int accNum = 0;
+
+    if(action->value == "DEPOSIT" || action->value == "WITHDRAW"){
+        bool deposit = action->value == "DEPOSIT";
+        Money amount = 0;
+        if(decodedField(decoder, "accountNumber", accNum, response) &&
+           decodedField(decoder, "amount", amount, response)){
+            BalanceResult result = deposit ? bank.depositBalance(accNum, amount) : bank.withdrawBalance(accNum, amount);
+            appendBalanceResponse(result, deposit, accNum, out);
+            outcome.kind = deposit ? RequestKind::DEPOSIT : RequestKind::WITHDRAW;
+            outcome.ok = result.code == BalanceResult::OK;
+            return true;
+        }
+    }else if(action->value == "TRANSFER"){
+        int accNum2 = 0;
+        Money amount = 0;
+        if(decodedField(decoder, "accountNumber1", accNum, response) &&
+           decodedField(decoder, "accountNumber2", accNum2, response) &&
+           decodedField(decoder, "amount", amount, response)){
+            response = bank.transfer(accNum, accNum2, amount);
+        }
+    }else if(action->value == "DISPLAY_ONE"){
+        if(decodedField(decoder, "accountNumber", accNum, response)){
+            response = bank.displayAccount(accNum);
+        }
+    }else if(action->value == "DELETE"){
+        if(decodedField(decoder, "accountNumber", accNum, response)){
+            response = bank.closeAccount(accNum);
+        }
+    }else if(action->value == "APPLY_INTEREST_ONE"){
+        if(decodedField(decoder, "accountNumber", accNum, response)){
+            response = bank.applyInterestOne(accNum);
+        }
+    }else{
+        return false;
+    }
+
+    outcome.kind = requestKindFromName(action->value);
+    outcome.ok = succeeded(response);
+    appendFrame(out, response.dump());
+    return true;
+}
+
+bool isBlockingRequest(const Session& session, std::string_view payload){
+    if(session.binary){
+        Opcode op = payload.empty() ? Opcode::EXIT : static_cast<Opcode>(payload[0]);
+        switch(op){
+            case Opcode::DISPLAY_ONE:
+            case Opcode::DISPLAY_ALL:
+            case Opcode::EXPORT_JSON: // the export itself runs as a background job
+            case Opcode::EXIT:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    // whatever the decoder declines (escapes, odd nesting) is handed off
+    RequestDecoder decoder;
+    const RequestDecoder::Field* action = nullptr;
+    if(!decoder.parse(payload) || (action = decoder.find("action")) == nullptr || action->kind != RequestDecoder::Kind::STRING){
+        return true;
+    }
+    for(std::string_view name : {"DISPLAY_ONE", "DISPLAY_ALL", "EXPORT_JSON", "EXPORT_STATUS", "STATS", "HELLO", "EXIT"}){
+        if(action->value == name){
+            return false;
+        }
+    }
+    return true; // mutations, SNAPSHOT, and anything unknown
+}
+
+void handleFrame(Session& session, std::string_view payload, std::string& out){
+    Metrics::Clock::time_point start = Metrics::Clock::now();
+    Outcome outcome;
+
+    if(session.binary){
+        handleBinaryRequest(session, payload, out, outcome);
+    }else if(!handleDecodedRequest(payload, out, outcome)){
+        json response = handleJsonRequest(session, std::string(payload), outcome.kind);
+        outcome.ok = succeeded(response);
+        appendFrame(out, response.dump());
+    }
+
+    Metrics::getInstance().recordRequest(outcome.kind, outcome.ok, Metrics::Clock::now() - start);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Per-connection protocol state
+struct Session{
+    bool binary = false;  // switched on by a HELLO handshake
+    bool closing = false; // client sent EXIT
+};
+
+// Parses one JSON request and dispatches it to the Bank.
+json handleRequest(Session& session, const std::string& request);
+
+// Handles one request frame in the session's current protocol and appends
+// the framed response to out.
+void handleFrame(Session& session, std::string_view payload, std::string& out);
+
+// True for requests that can hold their thread for long, which the event
+// loop runs off its thread: whole-table work, file writes, and every request
+// that may change an account, since it waits for its journal commit and may
+// checkpoint to Redis. May report false positives, never false negatives.
+bool isBlockingRequest(const Session& session, std::string_view payload);
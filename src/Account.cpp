@@ -1,6 +1,6 @@
-#include "Account.hpp"
+#include "AccountDispatch.hpp"
 
-Account::Account(int accNum, const std::string& name, double initialBalance){
+Account::Account(AccountType type, int accNum, const std::string& name, Money initialBalance) : type(type) {
     accountNumber = accNum;
     holderName = name;
     balance = initialBalance;
@@ -8,28 +8,110 @@ Account::Account(int accNum, const std::string& name, double initialBalance){
 
 Account::~Account() = default;
 
+json Account::withdraw(Money amount){
+    return visitAccount(*this, [amount](auto& acc){ return acc.withdraw(amount); });
+}
+
+json Account::display() const {
+    return visitAccount(*this, [](const auto& acc){ return acc.display(); });
+}
+
+json Account::toJson() const {
+    return visitAccount(*this, [](const auto& acc){ return acc.toJson(); });
+}
+
+bool Account::canWithdrawLocked(Money amount) const {
+    return visitAccount(*this, [amount](const auto& acc){ return acc.canWithdrawLocked(amount); });
+}
+
+AccountImage Account::imageLocked() const {
+    return visitAccount(*this, [](const auto& acc){ return acc.imageLocked(); });
+}
+
+void Account::imageLocked(AccountImage& out) const {
+    out.type = type;
+    out.accountNumber = accountNumber;
+    out.holderName.assign(holderName);
+    out.balance = balance;
+    out.rateOrLimit = visitAccount(*this, [](const auto& acc) -> int64_t {
+        if constexpr (std::is_same_v<std::decay_t<decltype(acc)>, SavingsAccount>){
+            return acc.getInterestRateLocked();
+        }else{
+            return acc.getOverDraftLimitLocked();
+        }
+    });
+}
+
+std::string Account::getHolderName() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return holderName;
+}
+
 int Account::getAccountNumber() const{
     return accountNumber;
 }
 
-double Account::getBalance() const{
+Money Account::getBalance() const{
+    std::lock_guard<std::mutex> lock(mtx);
     return balance;
 }
 
 void Account::setHolderName(const std::string& name){
+    std::lock_guard<std::mutex> lock(mtx);
     holderName = name;
 }
 
-void Account::setBalance(double newBalance){
+void Account::setBalance(Money newBalance){
+    std::lock_guard<std::mutex> lock(mtx);
+    balance = newBalance;
+}
+
+std::unique_lock<std::mutex> Account::lock() const{
+    return std::unique_lock<std::mutex>(mtx);
+}
+
+Money Account::getBalanceLocked() const{
+    return balance;
+}
+
+void Account::setBalanceLocked(Money newBalance){
     balance = newBalance;
 }
 
-json Account::deposit(double amount){
+std::shared_ptr<Account> Account::fromImage(const AccountImage& image){
+    if(image.type == AccountType::SAVINGS){
+        return std::make_shared<SavingsAccount>(image.accountNumber, image.holderName, image.balance, image.rateOrLimit);
+    }
+    return std::make_shared<CheckingAccount>(image.accountNumber, image.holderName, image.balance, static_cast<int>(image.rateOrLimit));
+}
+
+void Account::markClosed(){
+    closed = true;
+}
+
+bool Account::isClosed() const{
+    return closed;
+}
+
+void Account::markSaved(uint64_t written) const{
+    // writes of the same account can finish out of order; keep the newest
+    uint64_t saved = savedVersion.load(std::memory_order_relaxed);
+    while(saved < written && !savedVersion.compare_exchange_weak(saved, written, std::memory_order_relaxed)){
+    }
+}
+
+json Account::deposit(Money amount){
     std::lock_guard<std::mutex> lock(mtx);
     std::stringstream ss;
     json msg;
-    balance += amount;
-    ss << "New balance of $" << balance;
+    if(!money::add(balance, amount, balance)){
+        msg = {
+            {"status", "failed: "},
+            {"message", "Balance would overflow."}
+        };
+        return msg;
+    }
+    ss << "New balance of $" << money::toString(balance);
     msg = {
         {"status", "success: "},
         {"message", ss.str()}
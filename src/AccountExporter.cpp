@@ -0,0 +1,375 @@
+#include "AccountExporter.hpp"
+#include "Money.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace {
+    constexpr size_t BUFFER_BYTES = 1 << 20;
+    constexpr size_t CHUNK_SLOTS = 4096; // registry slots copied out per shard lock
+
+    // Appends into a fixed buffer and writes it out whenever it fills up
+    class BufferedWriter{
+    public:
+        explicit BufferedWriter(int fd) : fd(fd) {
+            buffer.reserve(BUFFER_BYTES);
+        }
+
+        void append(const char* data, size_t size){
+            if(buffer.size() + size > BUFFER_BYTES){
+                flush();
+            }
+            buffer.append(data, size);
+        }
+        void append(const char* text){ append(text, std::strlen(text)); }
+        void append(const std::string& text){ append(text.data(), text.size()); }
+        void append(char c){ append(&c, 1); }
+
+        bool flush(){
+            const char* p = buffer.data();
+            size_t size = buffer.size();
+            while(ok && size > 0){
+                ssize_t n = ::write(fd, p, size);
+                if(n == -1){
+                    if(errno == EINTR){
+                        continue;
+                    }
+                    ok = false;
+                    break;
+                }
+                p += n;
+                size -= static_cast<size_t>(n);
+                written += static_cast<uint64_t>(n);
+            }
+            buffer.clear();
+            return ok;
+        }
+
+        bool good() const { return ok; }
+        uint64_t bytes() const { return written + buffer.size(); }
+    private:
+        int fd;
+        std::string buffer;
+        uint64_t written = 0;
+        bool ok = true;
+    };
+
+    void appendInt(BufferedWriter& out, int64_t value){
+        char buf[money::MAX_CHARS];
+        out.append(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), value).ptr - buf));
+    }
+
+    void appendFixed(BufferedWriter& out, int64_t value, int digits, bool trimZeros){
+        char buf[money::MAX_CHARS];
+        out.append(buf, static_cast<size_t>(money::formatFixed(value, digits, buf, trimZeros) - buf));
+    }
+
+    void appendJsonString(BufferedWriter& out, const std::string& text){
+        out.append('"');
+        for(unsigned char c : text){
+            if(c == '"' || c == '\\'){
+                out.append('\\');
+                out.append(static_cast<char>(c));
+            }else if(c < 0x20){
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out.append(esc, 6);
+            }else{
+                out.append(static_cast<char>(c));
+            }
+        }
+        out.append('"');
+    }
+
+    void appendCsvField(BufferedWriter& out, const std::string& text){
+        if(text.find_first_of(",\"\r\n") == std::string::npos){
+            out.append(text);
+            return;
+        }
+        out.append('"');
+        for(char c : text){
+            if(c == '"'){
+                out.append('"');
+            }
+            out.append(c);
+        }
+        out.append('"');
+    }
+
+    // Same fields and text as Account::toJson, without building a json value
+    void writeJson(BufferedWriter& out, const AccountImage& image){
+        bool savings = image.type == AccountType::SAVINGS;
+        out.append(savings ? "{\"accountType\":\"SAVINGS\"" : "{\"accountType\":\"CHECKING\"");
+        out.append(",\"accountNumber\":");
+        appendInt(out, image.accountNumber);
+        out.append(",\"holderName\":");
+        appendJsonString(out, image.holderName);
+        out.append(",\"balance\":\"");
+        appendFixed(out, image.balance, money::CENT_DIGITS, false);
+        if(savings){
+            out.append("\",\"interestRate\":\"");
+            appendFixed(out, image.rateOrLimit, money::RATE_DIGITS, true);
+            out.append("\"}");
+        }else{
+            out.append("\",\"overdraftLimit\":");
+            appendInt(out, image.rateOrLimit);
+            out.append('}');
+        }
+    }
+
+    void writeCsv(BufferedWriter& out, const AccountImage& image){
+        bool savings = image.type == AccountType::SAVINGS;
+        out.append(savings ? "SAVINGS," : "CHECKING,");
+        appendInt(out, image.accountNumber);
+        out.append(',');
+        appendCsvField(out, image.holderName);
+        out.append(',');
+        appendFixed(out, image.balance, money::CENT_DIGITS, false);
+        out.append(',');
+        if(savings){
+            appendFixed(out, image.rateOrLimit, money::RATE_DIGITS, true);
+            out.append(',');
+        }else{
+            out.append(',');
+            appendInt(out, image.rateOrLimit);
+        }
+        out.append('\n');
+    }
+}
+
+bool AccountExporter::parseFormat(const std::string& name, ExportFormat& out){
+    if(name == "json"){
+        out = ExportFormat::JSON;
+    }else if(name == "ndjson"){
+        out = ExportFormat::NDJSON;
+    }else if(name == "csv"){
+        out = ExportFormat::CSV;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+const char* AccountExporter::formatName(ExportFormat format){
+    switch(format){
+        case ExportFormat::NDJSON: return "ndjson";
+        case ExportFormat::CSV: return "csv";
+        default: return "json";
+    }
+}
+
+void AccountExporter::configure(const ExportConfig& newConfig){
+    std::lock_guard<std::mutex> lock(mtx);
+    config = newConfig;
+}
+
+bool AccountExporter::resolvePath(const std::string& path, std::string& resolved, std::string& error) const {
+    if(path.empty() || path[0] == '/'){
+        error = "Export path must be relative to the export directory.";
+        return false;
+    }
+
+    // the target is a client's choice, so it may only name an export file
+    // inside the export directory: never a server file such as the journal
+    resolved = config.directory;
+    for(size_t begin = 0;;){
+        size_t end = path.find('/', begin);
+        std::string part = path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        if(part.empty() || part == "." || part == ".."){
+            error = "Export path may not contain empty, '.' or '..' parts.";
+            return false;
+        }
+        resolved += "/" + part;
+
+        struct stat st;
+        bool exists = ::lstat(resolved.c_str(), &st) == 0;
+        if(end == std::string::npos){
+            size_t dot = part.rfind('.');
+            std::string extension = dot == std::string::npos ? std::string() : part.substr(dot);
+            if(extension != ".json" && extension != ".ndjson" && extension != ".csv"){
+                error = "Export files must end in .json, .ndjson or .csv.";
+                return false;
+            }
+            if(exists && !S_ISREG(st.st_mode)){
+                error = "Export path " + path + " exists and is not a regular file.";
+                return false;
+            }
+            return true;
+        }
+        // lstat: a symlink is not a directory, so it cannot lead elsewhere
+        if(!exists || !S_ISDIR(st.st_mode)){
+            error = "Export directory " + path.substr(0, end) + " does not exist or is not a plain directory.";
+            return false;
+        }
+        begin = end + 1;
+    }
+}
+
+uint64_t AccountExporter::start(const AccountRegistry& registry, ExportFormat format, const std::string& path, std::string& error){
+    auto job = std::make_shared<Job>();
+    job->format = format;
+    job->total = registry.size();
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(running >= config.maxRunning){
+            error = "Too many exports running (" + std::to_string(running) + "); try again later.";
+            return 0;
+        }
+        ::mkdir(config.directory.c_str(), 0755); // first export; EEXIST otherwise
+        if(!resolvePath(path, job->path, error)){
+            return 0;
+        }
+
+        ++running;
+        job->id = nextId++;
+        jobs[job->id] = job;
+        while(jobs.size() > KEEP_JOBS && jobs.begin()->second->state != 0){
+            jobs.erase(jobs.begin());
+        }
+    }
+
+    std::thread([this, &registry, job](){
+        run(registry, job);
+        finished();
+    }).detach();
+    return job->id;
+}
+
+void AccountExporter::finished(){
+    std::lock_guard<std::mutex> lock(mtx);
+    --running;
+}
+
+void AccountExporter::run(const AccountRegistry& registry, const std::shared_ptr<Job>& job){
+    auto start = std::chrono::steady_clock::now();
+    // unique per job, so concurrent exports to one path cannot interleave
+    std::string tmpPath = job->path + ".tmp" + std::to_string(job->id);
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if(fd == -1){
+        job->error = std::string("cannot open ") + tmpPath + ": " + std::strerror(errno);
+        job->state = 2;
+        return;
+    }
+
+    BufferedWriter out(fd);
+    if(job->format == ExportFormat::JSON){
+        out.append("[\n");
+    }else if(job->format == ExportFormat::CSV){
+        out.append("accountType,accountNumber,holderName,balance,interestRate,overdraftLimit\n");
+    }
+
+    size_t exported = 0;
+    std::vector<std::shared_ptr<Account>> chunk;
+    for(size_t shard = 0, slot = 0; shard < AccountRegistry::SHARD_COUNT && out.good();){
+        chunk.clear();
+        slot = registry.shardRange(shard, slot, CHUNK_SLOTS, chunk);
+        if(slot == AccountRegistry::SHARD_END){
+            ++shard;
+            slot = 0;
+        }
+
+        for(const auto& acc : chunk){
+            AccountImage image;
+            {
+                std::unique_lock<std::mutex> lock = acc->lock();
+                if(acc->isClosed()){
+                    continue;
+                }
+                image = acc->imageLocked();
+            }
+
+            switch(job->format){
+                case ExportFormat::JSON:
+                    if(exported > 0){
+                        out.append(",\n");
+                    }
+                    writeJson(out, image);
+                    break;
+                case ExportFormat::NDJSON:
+                    writeJson(out, image);
+                    out.append('\n');
+                    break;
+                case ExportFormat::CSV:
+                    writeCsv(out, image);
+                    break;
+            }
+            ++exported;
+        }
+        // accounts created meanwhile can push the count past the start size
+        job->total = std::max(job->total.load(), exported);
+        job->exported = exported;
+        job->bytes = out.bytes();
+    }
+
+    if(job->format == ExportFormat::JSON){
+        out.append(exported > 0 ? "\n]\n" : "]\n");
+    }
+
+    bool ok = out.flush() && fsync(fd) == 0;
+    int err = errno;
+    ::close(fd);
+    if(ok && std::rename(tmpPath.c_str(), job->path.c_str()) != 0){
+        ok = false;
+        err = errno;
+    }
+
+    job->total = exported;
+    job->exported = exported;
+    job->bytes = out.bytes();
+    job->elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    if(!ok){
+        std::remove(tmpPath.c_str());
+        job->error = std::string("cannot write ") + job->path + ": " + std::strerror(err);
+        job->state = 2;
+        return;
+    }
+    job->state = 1;
+}
+
+bool AccountExporter::status(uint64_t id, json& out) const {
+    std::shared_ptr<Job> job;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(jobs.empty()){
+            return false;
+        }
+        auto it = id == 0 ? std::prev(jobs.end()) : jobs.find(id);
+        if(it == jobs.end()){
+            return false;
+        }
+        job = it->second;
+    }
+
+    static const char* STATES[] = {"running", "done", "failed"};
+    int state = job->state;
+    size_t total = job->total;
+    size_t exported = job->exported;
+
+    out = {
+        {"jobId", job->id},
+        {"state", STATES[state]},
+        {"format", formatName(job->format)},
+        {"path", job->path},
+        {"exported", exported},
+        {"total", total},
+        {"percent", total > 0 ? 100.0 * static_cast<double>(exported) / static_cast<double>(total) : (state == 1 ? 100.0 : 0.0)},
+        {"bytes", job->bytes.load()}
+    };
+    if(state != 0){
+        out["seconds"] = static_cast<double>(job->elapsedUs) / 1e6;
+    }
+    if(state == 2){
+        out["error"] = job->error;
+    }
+    return true;
+}
@@ -0,0 +1,124 @@
+#include "AccountIndex.hpp"
+
+namespace {
+    constexpr size_t MIN_CAPACITY = 16;
+
+    size_t roundUpPow2(size_t n){
+        size_t cap = MIN_CAPACITY;
+        while(cap < n){
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    int log2Of(size_t pow2){
+        int bits = 0;
+        while((static_cast<size_t>(1) << bits) < pow2){
+            ++bits;
+        }
+        return bits;
+    }
+}
+
+AccountIndex::AccountIndex(){
+    rehash(MIN_CAPACITY);
+}
+
+size_t AccountIndex::bucketFor(int accNum) const {
+    // Fibonacci hashing spreads sequential account numbers across the table
+    uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(accNum)) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h >> shift);
+}
+
+size_t AccountIndex::find(int accNum) const {
+    for(size_t i = bucketFor(accNum);; i = (i + 1) & mask){
+        const Entry& e = table[i];
+        if(e.slot == EMPTY){
+            return npos;
+        }
+        if(e.key == accNum){
+            return e.slot;
+        }
+    }
+}
+
+void AccountIndex::insert(int accNum, size_t slot){
+    // keep the load factor at or below 1/2 so probe sequences stay short
+    if((count + 1) * 2 > table.size()){
+        rehash(table.size() * 2);
+    }
+
+    for(size_t i = bucketFor(accNum);; i = (i + 1) & mask){
+        Entry& e = table[i];
+        if(e.slot == EMPTY){
+            e.key = accNum;
+            e.slot = static_cast<uint32_t>(slot);
+            ++count;
+            return;
+        }
+        if(e.key == accNum){
+            e.slot = static_cast<uint32_t>(slot);
+            return;
+        }
+    }
+}
+
+bool AccountIndex::erase(int accNum){
+    size_t i = bucketFor(accNum);
+    while(true){
+        if(table[i].slot == EMPTY){
+            return false;
+        }
+        if(table[i].key == accNum){
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+
+    // backward-shift deletion keeps probe chains intact without tombstones
+    size_t hole = i;
+    for(size_t j = (i + 1) & mask; table[j].slot != EMPTY; j = (j + 1) & mask){
+        size_t home = bucketFor(table[j].key);
+        // move the entry back if its home bucket is not cyclically within (hole, j]
+        if(((j - home) & mask) >= ((j - hole) & mask)){
+            table[hole] = table[j];
+            hole = j;
+        }
+    }
+    table[hole].slot = EMPTY;
+    --count;
+    return true;
+}
+
+void AccountIndex::reserve(size_t n){
+    if(n * 2 > table.size()){
+        rehash(roundUpPow2(n * 2));
+    }
+}
+
+void AccountIndex::clear(){
+    table.assign(MIN_CAPACITY, Entry{0, EMPTY});
+    mask = MIN_CAPACITY - 1;
+    shift = 64 - log2Of(MIN_CAPACITY);
+    count = 0;
+}
+
+size_t AccountIndex::size() const {
+    return count;
+}
+
+void AccountIndex::rehash(size_t newCapacity){
+    std::vector<Entry> old;
+    old.swap(table);
+
+    table.assign(newCapacity, Entry{0, EMPTY});
+    mask = newCapacity - 1;
+    shift = 64 - log2Of(newCapacity);
+    count = 0;
+
+    for(const Entry& e : old){
+        if(e.slot != EMPTY){
+            insert(e.key, e.slot);
+        }
+    }
+}
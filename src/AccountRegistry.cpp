@@ -0,0 +1,158 @@
+#include "AccountRegistry.hpp"
+#include <algorithm>
+
+size_t AccountRegistry::shardFor(int accNum){
+    return static_cast<uint32_t>(accNum) % SHARD_COUNT;
+}
+
+std::shared_ptr<Account> AccountRegistry::find(int accNum) const {
+    const Shard& shard = shards[shardFor(accNum)];
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    size_t pos = shard.index.find(accNum);
+    return pos != AccountIndex::npos ? shard.accounts[pos] : nullptr;
+}
+
+bool AccountRegistry::contains(int accNum) const {
+    const Shard& shard = shards[shardFor(accNum)];
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    return shard.index.find(accNum) != AccountIndex::npos;
+}
+
+bool AccountRegistry::insert(std::shared_ptr<Account> acc){
+    int accNum = acc->getAccountNumber();
+    Shard& shard = shards[shardFor(accNum)];
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    if(shard.index.find(accNum) != AccountIndex::npos){
+        return false;
+    }
+    if(!shard.freeSlots.empty()){
+        size_t pos = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+        shard.index.insert(accNum, pos);
+        shard.accounts[pos] = std::move(acc);
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    shard.index.insert(accNum, shard.accounts.size());
+    shard.accounts.push_back(std::move(acc));
+    count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::shared_ptr<Account> AccountRegistry::removeSlot(Shard& shard, size_t pos, int accNum){
+    // leave a hole for the next insert instead of moving another account
+    // into it, so a paging cursor never skips or repeats an account
+    std::shared_ptr<Account> removed = std::move(shard.accounts[pos]);
+    shard.index.erase(accNum);
+    if(pos == shard.accounts.size() - 1){
+        shard.accounts.pop_back();
+    }else{
+        shard.freeSlots.push_back(pos);
+    }
+    return removed;
+}
+
+std::shared_ptr<Account> AccountRegistry::erase(int accNum){
+    Shard& shard = shards[shardFor(accNum)];
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    size_t pos = shard.index.find(accNum);
+    if(pos == AccountIndex::npos){
+        return nullptr;
+    }
+    count.fetch_sub(1, std::memory_order_relaxed);
+    return removeSlot(shard, pos, accNum);
+}
+
+size_t AccountRegistry::evict(size_t n){
+    std::vector<std::shared_ptr<Account>> evicted; // destroyed after the locks are released
+    for(size_t visited = 0; visited < SHARD_COUNT && evicted.size() < n; ++visited){
+        Shard& shard = shards[clockShard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT];
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+
+        // two turns of the hand at most: the first may only clear bits
+        size_t steps = 2 * shard.accounts.size();
+        for(size_t step = 0; step < steps && evicted.size() < n && !shard.accounts.empty(); ++step){
+            if(shard.clockHand >= shard.accounts.size()){
+                shard.clockHand = 0;
+            }
+            size_t pos = shard.clockHand++;
+            const std::shared_ptr<Account>& acc = shard.accounts[pos];
+            // the shard lock stops new references being handed out, so a
+            // use count of one means no one else can be using it or have
+            // changes for it still on their way to Redis; a dirty account
+            // with none on their way had its write fail
+            if(!acc || acc->takeUsed() || acc.use_count() != 1 || acc->isDirty()){
+                continue;
+            }
+            evicted.push_back(removeSlot(shard, pos, acc->getAccountNumber()));
+            count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    return evicted.size();
+}
+
+std::vector<std::shared_ptr<Account>> AccountRegistry::shardSnapshot(size_t shard) const {
+    std::shared_lock<std::shared_mutex> lock(shards[shard].mtx);
+    const Shard& s = shards[shard];
+    if(s.freeSlots.empty()){
+        return s.accounts;
+    }
+
+    std::vector<std::shared_ptr<Account>> live;
+    live.reserve(s.index.size());
+    for(const auto& acc : s.accounts){
+        if(acc){
+            live.push_back(acc);
+        }
+    }
+    return live;
+}
+
+size_t AccountRegistry::shardRange(size_t shard, size_t from, size_t maxSlots, std::vector<std::shared_ptr<Account>>& out) const {
+    std::shared_lock<std::shared_mutex> lock(shards[shard].mtx);
+    const auto& accounts = shards[shard].accounts;
+    size_t end = std::min(accounts.size(), from + maxSlots);
+    for(size_t pos = from; pos < end; ++pos){
+        if(accounts[pos]){
+            out.push_back(accounts[pos]);
+        }
+    }
+    return end < accounts.size() ? end : SHARD_END;
+}
+
+void AccountRegistry::clear(){
+    // Every shard is emptied under all the locks at once, so no reader sees
+    // a half-cleared table, and by swapping in fresh storage: the locks are
+    // held for 64 swaps, and the old tables (whose capacity clear() would
+    // keep) are freed after they are released
+    struct Released{
+        std::vector<std::shared_ptr<Account>> accounts;
+        std::vector<size_t> freeSlots;
+        AccountIndex index;
+    };
+    std::vector<Released> released(SHARD_COUNT);
+
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(SHARD_COUNT);
+    for(Shard& shard : shards){
+        locks.emplace_back(shard.mtx);
+    }
+    for(size_t i = 0; i < SHARD_COUNT; ++i){
+        Shard& shard = shards[i];
+        count.fetch_sub(shard.index.size(), std::memory_order_relaxed);
+        std::swap(shard.accounts, released[i].accounts);
+        std::swap(shard.freeSlots, released[i].freeSlots);
+        std::swap(shard.index, released[i].index);
+        shard.clockHand = 0;
+    }
+    locks.clear();
+}
+
+void AccountRegistry::reserve(size_t count){
+    size_t perShard = count / SHARD_COUNT + 1;
+    for(Shard& shard : shards){
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        shard.accounts.reserve(perShard);
+        shard.index.reserve(perShard);
+    }
+}
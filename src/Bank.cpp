@@ -1,180 +1,194 @@
 #include "Bank.hpp"
+#include "JsonFields.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+bool Bank::accountExists(int accNum){
+    if(wholeTableInMemory()){
+        return accounts.contains(accNum);
+    }
+    return findAccount(accNum) != nullptr;
+}
 
-template <typename T>
-bool validateJsonField(const json& obj, const std::string& key, json& msg, T& out){
-    std::stringstream ss;
+size_t Bank::accountCount() const {
+    return accounts.size();
+}
 
-    if (!obj.contains(key)){
-        ss << "Missing field '" << key << "'";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return false;
-    }
+json Bank::deposit(const json& accJson){
+    json msg;
+    int accNum;
+    Money amount;
 
-    if constexpr (std::is_same_v<T, int>) {
-        const std::string strVal = obj[key].get<std::string>();
-            
-        // Check if the string is a valid integer
-        if (strVal.empty() || strVal.find_first_not_of("-0123456789") != std::string::npos){
-            ss << "Invalid integer format for '" << key << "'. Must contain only digits.";
-            msg["status"] = "failed: ";
-            msg["message"] = ss.str();
-            return false;
-        }
-
-        try {
-            size_t pos = 0;
-            long num = std::stol(strVal, &pos); // Using stol to detect overflow
-            
-            // Ensure the entire string was parsed (no trailing chars)
-            if (pos != strVal.length()){
-                ss << "Invalid integer format for '" << key << "'. Trailing characters detected.";
-                msg["status"] = "failed: ";
-                msg["message"] = ss.str();
-                return false;
-            }
+    if(!validateJsonField(accJson, "accountNumber", msg, accNum)){
+        return msg;
+    }
 
-            // Check for int range
-            if (num < std::numeric_limits<int>::min() || num > std::numeric_limits<int>::max()){
-                ss << "Integer value for '" << key << "' is out of range.";
-                msg["status"] = "failed: ";
-                msg["message"] = ss.str();
-                return false;
-            }
+    if(!validateJsonField(accJson, "amount", msg, amount)){
+        return msg;
+    }
 
-            out = static_cast<int>(num);
-            return true;
-        }
-        catch (const std::invalid_argument&){
-            ss << "Invalid integer format for '" << key << "'";
-            msg["status"] = "failed: ";
-            msg["message"] = ss.str();
-            return false;
-        }
-        catch (const std::out_of_range&){
-            ss << "Integer value for '" << key << "' is out of range.";
-            msg["status"] = "failed: ";
-            msg["message"] = ss.str();
-            return false;
-        }
-    }else if constexpr (std::is_same_v<T, double>){
-        const std::string strVal = obj[key].get<std::string>();
+    return deposit(accNum, amount);
+}
 
-        try {
-            size_t pos = 0;
-            double num = std::stod(strVal, &pos);
+json Bank::deposit(int accNum, Money amount){
+    json msg;
+    char text[BALANCE_MESSAGE_MAX];
 
-            // Ensure the entire string was parsed (no trailing chars)
-            if (pos != strVal.length()){
-                ss << "Invalid double format for '" << key << "'. Trailing characters detected.";
-                msg["status"] = "failed: ";
-                msg["message"] = ss.str();
-                return false;
-            }
+    BalanceResult result = depositBalance(accNum, amount);
+    msg["status"] = result.code == BalanceResult::OK ? "success: " : "failed: ";
+    msg["message"] = std::string(balanceMessage(result, true, accNum, text));
+    return msg;
+}
 
-            out = num;
-            return true;
-        }
-        catch (const std::invalid_argument&){
-            ss << "Invalid double format for '" << key << "'";
-            msg["status"] = "failed: ";
-            msg["message"] = ss.str();
-            return false;
-        }
-        catch (const std::out_of_range&){
-            ss << "Double value for '" << key << "' is out of range.";
-            msg["status"] = "failed: ";
-            msg["message"] = ss.str();
-            return false;
-        }
+BalanceResult Bank::depositBalance(int accNum, Money amount){
+    BalanceResult result;
 
-        ss << "Invalid type for '" << key << "'. Expected double.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return false;
-    }else if constexpr (std::is_same_v<T, std::string>){
-        out = obj[key].get<T>();
-        return true;
-    }else{
-        ss << "Unsupported type for '" << key << "'.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return false;
+    std::shared_ptr<Account> acc = findAccount(accNum);
+    if(acc == nullptr){
+        result.code = BalanceResult::NOT_FOUND;
+        return result;
     }
-}
 
-bool Bank::accountExists(int accNum) const {
-    for(const auto& acc : accounts){
-        if(acc->getAccountNumber() == accNum){
-            return true;
-        }
+    {
+        std::unique_lock<std::mutex> lock = acc->lock();
+        result = depositLocked(*acc, amount);
+    }
+    if(result.code == BalanceResult::OK && !persist(acc)){
+        result.code = BalanceResult::NOT_DURABLE;
     }
-    return false;
+    return result;
 }
 
-json Bank::deposit(const json& accJson){
-    json msg;
-    int accNum;
-    double amount;
+BalanceResult Bank::withdrawBalance(int accNum, Money amount){
+    BalanceResult result;
 
-    if(!validateJsonField(accJson, "accountNumber", msg, accNum)){
-        return msg;
+    std::shared_ptr<Account> acc = findAccount(accNum);
+    if(acc == nullptr){
+        result.code = BalanceResult::NOT_FOUND;
+        return result;
     }
 
-    if(!validateJsonField(accJson, "amount", msg, amount)){
-        return msg;
+    {
+        std::unique_lock<std::mutex> lock = acc->lock();
+        result = withdrawLocked(*acc, amount);
+    }
+    if(result.code == BalanceResult::OK && !persist(acc)){
+        result.code = BalanceResult::NOT_DURABLE;
+    }
+    return result;
+}
+
+BalanceResult Bank::depositLocked(Account& acc, Money amount){
+    BalanceResult result;
+    result.type = acc.getType();
+
+    // closed between lookup and locking
+    if(acc.isClosed()){
+        result.code = BalanceResult::NOT_FOUND;
+    }else if(amount < 0){
+        result.code = BalanceResult::NEGATIVE_AMOUNT;
+    }else if(!money::add(acc.getBalanceLocked(), amount, result.balance)){
+        result.code = BalanceResult::OUT_OF_RANGE;
+    }else{
+        acc.setBalanceLocked(result.balance);
     }
+    return result;
+}
 
-    Account* acc = findAccount(accNum);
-    if(acc == nullptr){
-        std::stringstream ss;
-        ss << "Account #" << accNum << " not found.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return msg;
+BalanceResult Bank::withdrawLocked(Account& acc, Money amount){
+    BalanceResult result;
+    result.type = acc.getType();
+
+    if(acc.isClosed()){
+        result.code = BalanceResult::NOT_FOUND;
+    }else if(amount < 0){
+        result.code = BalanceResult::NEGATIVE_AMOUNT;
+    }else if(!acc.canWithdrawLocked(amount)){
+        result.code = BalanceResult::INSUFFICIENT_FUNDS;
+    }else{
+        result.balance = acc.getBalanceLocked() - amount;
+        acc.setBalanceLocked(result.balance);
     }
+    return result;
+}
 
-    if(amount < 0.0){
-        std::stringstream ss;
-        ss << "Cannot deposit negative amount.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return msg;
+std::string_view Bank::balanceMessage(const BalanceResult& result, bool deposit, int accNum, char* buf){
+    char* out = buf;
+    auto put = [&out](std::string_view text){
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    };
+
+    switch(result.code){
+        case BalanceResult::OK:
+            put("New balance of $");
+            out = money::formatFixed(result.balance, money::CENT_DIGITS, out);
+            break;
+        case BalanceResult::NOT_FOUND:
+            put("Account #");
+            out = std::to_chars(out, buf + BALANCE_MESSAGE_MAX, accNum).ptr;
+            put(" not found.");
+            break;
+        case BalanceResult::NEGATIVE_AMOUNT:
+            put(deposit ? "Cannot deposit negative amount." : "Cannot withdraw negative amount.");
+            break;
+        case BalanceResult::INSUFFICIENT_FUNDS:
+            put(result.type == AccountType::SAVINGS ? "Insufficient funds in savings account." : "Overdraft limit exceeded.");
+            break;
+        case BalanceResult::OUT_OF_RANGE:
+            put("Balance would overflow.");
+            break;
+        case BalanceResult::NOT_DURABLE:
+            put("Journal write failed, the change is not durable.");
+            break;
     }
+    return std::string_view(buf, static_cast<size_t>(out - buf));
+}
 
-    msg = acc->deposit(amount);
-    RedisCache::getInstance().saveAccount(*acc);
+json Bank::depositTo(Account& acc, Money amount){
+    json msg;
+    char text[BALANCE_MESSAGE_MAX];
+
+    BalanceResult result = depositLocked(acc, amount);
+    msg["status"] = result.code == BalanceResult::OK ? "success: " : "failed: ";
+    msg["message"] = std::string(balanceMessage(result, true, acc.getAccountNumber(), text));
     return msg;
 }
 
 json Bank::withdraw(const json& accJson){
     json msg;
     int accNum;
-    double amount;
+    Money amount;
 
     if(!validateJsonField(accJson, "accountNumber", msg, accNum)){
         return msg;
     }
 
-    Account* acc = findAccount(accNum);
-    if(acc == nullptr){
-        std::stringstream ss;
-        ss << "Account #" << accNum << " not found.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
+    if(!validateJsonField(accJson, "amount", msg, amount)){
         return msg;
     }
 
-    if(amount < 0.0){
-        std::stringstream ss;
-        ss << "Cannot withdraw negative amount.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return msg;
-    }
+    return withdraw(accNum, amount);
+}
+
+json Bank::withdraw(int accNum, Money amount){
+    json msg;
+    char text[BALANCE_MESSAGE_MAX];
+
+    BalanceResult result = withdrawBalance(accNum, amount);
+    msg["status"] = result.code == BalanceResult::OK ? "success: " : "failed: ";
+    msg["message"] = std::string(balanceMessage(result, false, accNum, text));
+    return msg;
+}
+
+json Bank::withdrawFrom(Account& acc, Money amount){
+    json msg;
+    char text[BALANCE_MESSAGE_MAX];
 
-    msg = acc->withdraw(amount);
-    RedisCache::getInstance().saveAccount(*acc);
+    BalanceResult result = withdrawLocked(acc, amount);
+    msg["status"] = result.code == BalanceResult::OK ? "success: " : "failed: ";
+    msg["message"] = std::string(balanceMessage(result, false, acc.getAccountNumber(), text));
     return msg;
 }
 
@@ -185,7 +199,13 @@ json Bank::displayAccount(const json& accJson){
         return msg;
     }
 
-    Account* acc = findAccount(accNum);
+    return displayAccount(accNum);
+}
+
+json Bank::displayAccount(int accNum){
+    json msg;
+
+    std::shared_ptr<Account> acc = findAccount(accNum);
     if(acc == nullptr){
         std::stringstream ss;
         ss << "Account #" << accNum << " not found.";
@@ -206,35 +226,127 @@ json Bank::displayAccount(const json& accJson){
     return allAccounts;
 } */
 
-json Bank::displayAllAccounts() const {
-    json result;
-    result["accounts"] = json::array();
-    
-    for(const auto& acc : accounts) {
-        if(!acc) continue;
-        
-        json accData;
-        accData["accountType"] = acc->getAccountType(); // "SAVINGS" or "CHECKING"
-        accData["accountNumber"] = acc->getAccountNumber();
-        accData["holderName"] = acc->getHolderName();
-        accData["balance"] = acc->getBalance();
-        
-        if(acc->getAccountType() == "SAVINGS") {
-            accData["interestRate"] = dynamic_cast<SavingsAccount*>(acc.get())->getInterestRate();
-        } else {
-            accData["overdraftLimit"] = dynamic_cast<CheckingAccount*>(acc.get())->getOverDraftLimit();
-        }
-        
-        result["accounts"].push_back(accData);
+json Bank::displayAllAccounts(const json& accJson) const {
+    std::stringstream ss;
+    json msg;
+    uint64_t cursor = 0;
+    int limit = static_cast<int>(DEFAULT_PAGE_SIZE);
+    std::optional<AccountType> type;
+
+    if(!wholeTableInMemory()){
+        return needsWholeTable("DISPLAY_ALL");
     }
-    
-    result["status"] = "success";
-    result["message"] = "Accounts retrieved";
-    return result;
+
+    if(accJson.contains("cursor") && !accJson["cursor"].is_null() &&
+       !parseCursor(accJson["cursor"].get_ref<const std::string&>(), cursor)){
+        ss << "Invalid cursor.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    if(accJson.contains("limit") && !validateJsonField(accJson, "limit", msg, limit)){
+        return msg;
+    }
+    if(limit < 1 || static_cast<size_t>(limit) > MAX_PAGE_SIZE){
+        ss << "Page limit must be between 1 and " << MAX_PAGE_SIZE << ".";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    if(accJson.contains("accountType")){
+        const std::string& name = accJson["accountType"].get_ref<const std::string&>();
+        AccountType filter;
+        if(parseAccountType(name, filter)){
+            type = filter;
+        }else{
+            ss << "Unknown account type '" << name << "'.";
+            msg["status"] = "failed: ";
+            msg["message"] = ss.str();
+            return msg;
+        }
+    }
+
+    AccountPage page;
+    if(!listAccounts(cursor, static_cast<size_t>(limit), type, page)){
+        ss << "Invalid cursor.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    json list = json::array();
+    for(const AccountImage& image : page.accounts){
+        bool savings = image.type == AccountType::SAVINGS;
+        json accData = {
+            {"accountType", accountTypeName(image.type)},
+            {"accountNumber", image.accountNumber},
+            {"holderName", image.holderName},
+            {"balance", money::toString(image.balance)}
+        };
+        if(savings){
+            accData["interestRate"] = money::rateToString(image.rateOrLimit);
+        }else{
+            accData["overdraftLimit"] = image.rateOrLimit;
+        }
+        list.push_back(std::move(accData));
+    }
+
+    ss << page.accounts.size() << " accounts retrieved";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    msg["accounts"] = std::move(list);
+    msg["nextCursor"] = page.nextCursor ? json(cursorToString(page.nextCursor)) : json(nullptr);
+    return msg;
+}
+
+bool Bank::listAccounts(uint64_t cursor, size_t limit, std::optional<AccountType> type, AccountPage& page) const {
+    // cursor = shard << 40 | slot within the shard
+    constexpr int SLOT_BITS = 40;
+    constexpr uint64_t SLOT_MASK = (uint64_t{1} << SLOT_BITS) - 1;
+    // a filtered page may come back short rather than scan without bound
+    constexpr size_t SCAN_FACTOR = 8;
+
+    size_t shard = static_cast<size_t>(cursor >> SLOT_BITS);
+    size_t slot = static_cast<size_t>(cursor & SLOT_MASK);
+    if(shard >= AccountRegistry::SHARD_COUNT){
+        return false;
+    }
+
+    page.accounts.clear();
+    page.accounts.reserve(limit);
+    size_t budget = limit * SCAN_FACTOR;
+    std::vector<std::shared_ptr<Account>> chunk;
+
+    while(shard < AccountRegistry::SHARD_COUNT && page.accounts.size() < limit && budget > 0){
+        size_t want = std::min(budget, limit - page.accounts.size());
+        chunk.clear();
+        slot = accounts.shardRange(shard, slot, want, chunk);
+        // charge what was found (and one per call), not what was asked for,
+        // so small shards do not eat the budget
+        budget -= std::min(budget, chunk.size() + 1);
+        if(slot == AccountRegistry::SHARD_END){
+            ++shard;
+            slot = 0;
+        }
+
+        for(const auto& acc : chunk){
+            std::unique_lock<std::mutex> lock = acc->lock();
+            if(acc->isClosed()){
+                continue;
+            }
+            AccountImage image = acc->imageLocked();
+            lock.unlock();
+            if(!type || image.type == *type){
+                page.accounts.push_back(std::move(image));
+            }
+        }
+    }
+
+    page.nextCursor = shard < AccountRegistry::SHARD_COUNT ? (static_cast<uint64_t>(shard) << SLOT_BITS) | slot : 0;
+    return true;
 }
 
 json Bank::closeAccount(const json& accJson){
-    std::stringstream ss;
     json msg;
     int accNum;
 
@@ -242,18 +354,50 @@ json Bank::closeAccount(const json& accJson){
         return msg;
     }
 
-    auto it = std::find_if(accounts.begin(), accounts.end(), 
-                [accNum](const std::unique_ptr<Account>& acc){
-                    return acc->getAccountNumber() == accNum;
-                });
+    return closeAccount(accNum);
+}
+
+json Bank::closeAccount(int accNum){
+    std::stringstream ss;
+    json msg;
+
+    std::shared_ptr<Account> acc = findAccount(accNum);
+    bool closed = false;
+    bool durable = true;
+
+    if(acc){
+        std::shared_lock<std::shared_mutex> gate(checkpointGate);
+        uint64_t lsn = 0;
+        {
+            // journal the delete before the number can be reused, so a new
+            // account's records always follow it
+            std::unique_lock<std::mutex> lock = acc->lock();
+            if(!acc->isClosed()){
+                acc->markClosed();
+                lsn = Journal::getInstance().appendDelete(accNum);
+                closed = true;
+            }
+        }
+        if(closed){
+            // in hot-set mode, keep a miss on this number from reloading it
+            // from Redis between the erase and the queued delete
+            std::unique_lock<std::mutex> stripe(loadStripe(accNum), std::defer_lock);
+            if(!wholeTableInMemory()){
+                stripe.lock();
+            }
+            accounts.erase(accNum);
+            durable = Journal::getInstance().commit(lsn);
+            WriteBehindQueue::getInstance().enqueueDelete(accNum); // delete account from Redis
+        }
+    }
     
-    if(it != accounts.end()){
-        accounts.erase(it); // unique pointer is deleted here
-        RedisCache::getInstance().deleteAccount(accNum); // delete account from Redis
-        saveAllAccounts(); // update Redis
+    if(closed){
         ss << "Acount #" << accNum << " closed";
         msg["status"] = "success: ";
         msg["message"] = ss.str();
+        if(!durable){
+            markNotDurable(msg);
+        }
         return msg;
     }else{
         ss << "Account #" << accNum << " not found";
@@ -272,7 +416,7 @@ json Bank::modifyAccount(const json& accJson){
         return msg;
     }
 
-    Account* acc = findAccount(accNum);
+    std::shared_ptr<Account> acc = findAccount(accNum);
     if(acc == nullptr){
         ss << "Account #" << accNum << " not found";
         msg["status"] = "failed: ";
@@ -281,189 +425,760 @@ json Bank::modifyAccount(const json& accJson){
     }
 
     std::string newName;
-    if(validateJsonField(accJson, "holderName", msg, newName)){
-        if(newName != "0"){
-            acc->setHolderName(newName);
-        }
-    }else{
+    if(!validateJsonField(accJson, "holderName", msg, newName)){
         return msg;
     }
 
-    double newBalance;
-    if(validateJsonField(accJson, "balance", msg, newBalance)){
-        if(newBalance != 0.0){
-            acc->setBalance(newBalance);
-        }
-    }else{
+    Money newBalance;
+    if(!validateJsonField(accJson, "balance", msg, newBalance)){
         return msg;
     }
 
-    if(acc->getAccountType() == "SAVINGS"){
-        double newInterestRate;
-        auto* savings = dynamic_cast<SavingsAccount*>(acc);
-        if(validateJsonField(accJson, "interestRate", msg, newInterestRate)){
-            if(newInterestRate != 0.0){
-                savings->setInterestRate(newInterestRate);
-            }
-        }else{
+    Rate newInterestRate = 0;
+    int newOverdraftLimit = 0;
+    if(acc->getType() == AccountType::SAVINGS){
+        if(!validateRateField(accJson, "interestRate", msg, newInterestRate)){
             return msg;
         }
-    }else if(acc->getAccountType() == "CHECKING"){
-        int newOverdraftLimit;
-        auto* checking = dynamic_cast<CheckingAccount*>(acc);
-        if(validateJsonField(accJson, "overdraftLimit", msg, newOverdraftLimit)){
-            if(newOverdraftLimit != 0){
-                checking->setOverDraftLimit(newOverdraftLimit);
-            }
-        }else{
+    }else{
+        if(!validateJsonField(accJson, "overdraftLimit", msg, newOverdraftLimit)){
             return msg;
         }
-    }else{
-        ss << "Unknown account type.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return msg;
-    }
-
-    RedisCache::getInstance().saveAccount(*acc);
-    ss << "Account #" << acc->getAccountNumber() << " updated";
-    msg["status"] = "success: ";
-    msg["message"] = ss.str();
-    return msg;
-}
-
-json Bank::saveAllAccounts() const {
-    std::stringstream ss;
-    json msg;
-    for(const auto& acc : accounts){
-        RedisCache::getInstance().saveAccount(*acc);
     }
 
-    ss << "All accounts saved";
-    msg["status"] = "success: ";
-    msg["message"] = ss.str();
-    return msg;
+    return modifyAccount(accNum, newName, newBalance, newInterestRate, newOverdraftLimit);
 }
 
-json Bank::loadAllAccounts(){
+// "0" / 0 leave the corresponding field unchanged
+json Bank::modifyAccount(int accNum, const std::string& newName, Money newBalance, Rate newInterestRate, int newOverdraftLimit){
     std::stringstream ss;
     json msg;
-    accounts.clear();
-    
-    std::vector<std::string> keys = RedisCache::getInstance().getAllAccountKeys();
 
-    for(const auto& key : keys){
-        int accNum = std::stoi(key.substr(key.find(":") + 1));
-        std::unique_ptr<Account> acc = RedisCache::getInstance().loadAccount(accNum);
-        if(acc){
-            accounts.push_back(std::move(acc));
-        }
+    std::shared_ptr<Account> acc = findAccount(accNum);
+    if(acc == nullptr){
+        ss << "Account #" << accNum << " not found";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
     }
 
-    ss << "All accounts loaded";
-    msg["status"] = "success: ";
-    msg["message"] = ss.str();
+    {
+        std::unique_lock<std::mutex> lock = acc->lock();
+        msg = applyModification(*acc, newName, newBalance, newInterestRate, newOverdraftLimit);
+    }
+    if(msg["status"] == "success: " && !persist(acc)){
+        markNotDurable(msg);
+    }
     return msg;
 }
 
-Account* Bank::findAccount(int accNum) const {
-    for(const auto& acc : accounts){
-        if(acc->getAccountNumber() == accNum){
-            return acc.get();
-        }
+// refused rather than cut short, so a journal replay restores the same name
+static bool holderNameFits(const std::string& name, json& msg){
+    if(name.size() > MAX_HOLDER_NAME){
+        msg["status"] = "failed: ";
+        msg["message"] = "Holder name is too long (at most " + std::to_string(MAX_HOLDER_NAME) + " bytes).";
+        return false;
     }
-    return nullptr;
+    return true;
 }
 
-json Bank::applyInterestOne(const json& accJson){
-    json msg;
+json Bank::applyModification(Account& acc, const std::string& newName, Money newBalance, Rate newInterestRate, int newOverdraftLimit){
     std::stringstream ss;
+    json msg;
 
-    int accNum;
-    if(!validateJsonField(accJson, "accountNumber", msg, accNum)){
-        return msg;
-    }
-
-    Account* acc = findAccount(accNum);
-    if(acc == nullptr){
-        ss << "Account #" << accNum << " not found.";
+    // closed between lookup and locking
+    if(acc.isClosed()){
+        ss << "Account #" << acc.getAccountNumber() << " not found";
         msg["status"] = "failed: ";
         msg["message"] = ss.str();
         return msg;
     }
 
-    if(acc->getAccountType() == "SAVINGS"){
-        auto* savings = dynamic_cast<SavingsAccount*>(acc);
-        msg = savings->applyInterest();
-        RedisCache::getInstance().saveAccount(*acc);
+    if(newName != "0" && !holderNameFits(newName, msg)){
         return msg;
-    }else{
-        ss << "This is not a savings account.";
+    }
+
+    // binary MODIFY cannot tell a rate from a limit until the type is known
+    if(acc.getType() == AccountType::SAVINGS && !fields::rateInRange(newInterestRate)){
         msg["status"] = "failed: ";
-        msg["message"] = ss.str();
+        msg["message"] = fields::message(fields::Error::RATE_RANGE, "interestRate");
         return msg;
     }
-}
 
-json Bank::applyInterestAll(const json& accJson){
-    json msg;
-    std::stringstream ss;
-    int count = 0;
-    
-    for(const auto& acc : accounts){
-        if(acc->getAccountType() == "SAVINGS"){
-            auto* savings = dynamic_cast<SavingsAccount*>(acc.get());
-            savings->applyInterest();
-            RedisCache::getInstance().saveAccount(*acc);
-            ++count;
+    visitAccount(acc, [&](auto& typed){
+        if constexpr (std::is_same_v<std::decay_t<decltype(typed)>, SavingsAccount>){
+            if(newInterestRate != 0){
+                typed.setInterestRateLocked(newInterestRate);
+            }
+        }else{
+            if(newOverdraftLimit != 0){
+                typed.setOverDraftLimitLocked(newOverdraftLimit);
+            }
         }
-    }
-    ss << "Interest applied to all";
-    msg["status"] = "success: ";
-    msg["message"] = ss.str();
-    return msg;
-}
+    });
 
-json Bank::exportAllAccountsToFile() const {
-    std::stringstream ss;
-    json msg;
-    
-    std::ofstream file("accounts_export.json", std::ios::trunc);
-    
-    if(!file.is_open()){
-        ss << "Failed to open JSON export file.";
-        msg["status"] = "failed: ";
-        msg["message"] = ss.str();
-        return msg;
+    if(newName != "0"){
+        acc.setHolderNameLocked(newName);
     }
 
-    json allAccounts = json::array();
-    for(const auto& acc : accounts){
-        allAccounts.push_back(acc->toJson());
+    if(newBalance != 0){
+        acc.setBalanceLocked(newBalance);
     }
 
-    file << allAccounts.dump(4);
-    file.close();
-    ss << "All accounts exported";
+    ss << "Account #" << acc.getAccountNumber() << " updated";
     msg["status"] = "success: ";
     msg["message"] = ss.str();
     return msg;
 }
 
-json Bank::createAccountFromJson(const json& acc){
-    std::string name, accountType;
+bool Bank::persist(const std::shared_ptr<Account>& acc){
+    // the single-account path every request takes: no vector, and the image
+    // buffer is reused per thread so long holder names do not allocate
+    thread_local AccountImage image;
+    bool durable;
+    {
+        std::shared_lock<std::shared_mutex> gate(checkpointGate);
+        uint64_t lsn = 0;
+        {
+            std::unique_lock<std::mutex> lock = acc->lock();
+            if(!acc->isClosed()){
+                acc->markDirtyLocked();
+                acc->imageLocked(image);
+                lsn = Journal::getInstance().appendSave(image);
+            }
+        }
+        durable = Journal::getInstance().commit(lsn);
+        // queued either way: memory already holds the change, and once Redis
+        // has it a checkpoint can start a working journal
+        WriteBehindQueue::getInstance().enqueueSave(acc);
+    }
+    checkpointIfNeeded();
+    return durable;
+}
+
+bool Bank::persist(const std::vector<std::shared_ptr<Account>>& accs){
+    bool durable;
+    {
+        std::shared_lock<std::shared_mutex> gate(checkpointGate);
+        uint64_t lsn = 0;
+        for(const auto& acc : accs){
+            // capture and append under the account lock so the journal holds
+            // this account's states in the order they happened
+            std::unique_lock<std::mutex> lock = acc->lock();
+            if(!acc->isClosed()){
+                acc->markDirtyLocked();
+                lsn = std::max(lsn, Journal::getInstance().appendSave(acc->imageLocked()));
+            }
+        }
+        durable = Journal::getInstance().commit(lsn);
+        WriteBehindQueue::getInstance().enqueueSaves(accs);
+    }
+    checkpointIfNeeded();
+    return durable;
+}
+
+void Bank::markNotDurable(json& msg){
+    msg["status"] = "failed: ";
+    msg["message"] = msg["message"].get<std::string>() + " (journal write failed, not durable)";
+}
+
+bool Bank::checkpoint() const {
+    std::unique_lock<std::shared_mutex> gate(checkpointGate);
+    // the journal is the only durable copy of whatever Redis did not take
+    if(!WriteBehindQueue::getInstance().flush()){
+        std::cerr << "[Server] Checkpoint skipped: Redis did not take every write, keeping the journal\n";
+        return false;
+    }
+    return Journal::getInstance().reset();
+}
+
+void Bank::checkpointIfNeeded() const {
+    if(!Journal::getInstance().needsCheckpoint()){
+        return;
+    }
+    // after a failure, let requests through for a while before stalling
+    // them on the gate for another attempt
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    if(now < checkpointRetryAt.load(std::memory_order_relaxed)){
+        return;
+    }
+    if(!checkpoint()){
+        checkpointRetryAt.store((std::chrono::steady_clock::now() + CHECKPOINT_RETRY).time_since_epoch().count(),
+                                std::memory_order_relaxed);
+    }
+}
+
+size_t Bank::replayJournal(){
+    std::unordered_map<int, JournalOp> lastOp;
+    size_t replayed = Journal::getInstance().replay([this, &lastOp](const JournalRecord& rec){
+        accounts.erase(rec.image.accountNumber);
+        if(rec.op == JournalOp::SAVE){
+            std::shared_ptr<Account> acc = Account::fromImage(rec.image);
+            {
+                std::unique_lock<std::mutex> lock = acc->lock();
+                acc->markDirtyLocked(); // Redis may not have this state
+            }
+            accounts.insert(acc);
+            knownAccounts.add(rec.image.accountNumber);
+        }
+        lastOp[rec.image.accountNumber] = rec.op;
+    });
+
+    if(replayed == 0){
+        return 0;
+    }
+
+    // bring Redis up to date, after which the journal can start over
+    for(const auto& [accNum, op] : lastOp){
+        if(op == JournalOp::SAVE){
+            WriteBehindQueue::getInstance().enqueueSave(findAccount(accNum));
+        }else{
+            WriteBehindQueue::getInstance().enqueueDelete(accNum);
+        }
+    }
+    checkpoint();
+    std::cout << "[Server] Replayed " << replayed << " journal records (" << lastOp.size() << " accounts)\n";
+    return replayed;
+}
+
+json Bank::saveAllAccounts() const {
+    std::stringstream ss;
+    json msg;
+    size_t queued = 0;
+    // only accounts changed since Redis last took them (or whose write failed)
+    accounts.forEach([&queued](const std::shared_ptr<Account>& acc){
+        if(WriteBehindQueue::getInstance().enqueueIfDirty(acc)){
+            ++queued;
+        }
+    });
+    if(!checkpoint()){ // flushes
+        ss << "Checkpoint failed (" << queued << " changed); the writes stay queued and the journal is kept.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    ss << "All accounts saved (" << queued << " changed)";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    return msg;
+}
+
+json Bank::loadAllAccounts(){
+    constexpr size_t LOAD_BATCH = 1000;
+    std::stringstream ss;
+    json msg;
+    auto start = std::chrono::steady_clock::now();
+    accounts.clear();
+
+    if(!wholeTableInMemory()){
+        // only the account numbers; accounts come in as requests need them.
+        // Headroom for the book to double before the filter's error grows
+        std::vector<int> accNums = RedisCache::getInstance().getAllAccountNumbers();
+        knownAccounts.reset(std::max<size_t>(2 * accNums.size(), 1 << 16));
+        for(int accNum : accNums){
+            knownAccounts.add(accNum);
+        }
+        replayJournal(); // checkpoints, so the replayed accounts can be evicted
+        evictIfNeeded();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "[Server] Indexed " << accNums.size() << " accounts for the hot-set cache (" << hotSetCapacity
+                  << " in memory at most, " << knownAccounts.bytes() / 1024 << " KiB filter) in " << seconds << " s\n";
+        ss << "Hot-set cache ready (" << accNums.size() << " accounts in Redis)";
+        msg["status"] = "success: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    size_t snapshotAccounts = 0;
+    if(loadSnapshot(snapshotAccounts)){
+        // committed mutations since the snapshot; replaying checkpoints the
+        // journal, which leaves this snapshot behind its base
+        size_t replayed = replayJournal();
+        tableLoaded = true;
+        if(replayed > 0){
+            refreshSnapshot();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "[Server] Loaded " << accounts.size() << " accounts from snapshot in " << seconds << " s\n";
+        ss << "All accounts loaded from snapshot (" << accounts.size() << " accounts)";
+        msg["status"] = "success: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    
+    std::vector<int> accNums;
+    try{
+        accNums = RedisCache::getInstance().getAllAccountNumbers();
+    }catch(const sw::redis::Error& err){
+        std::cerr << "Redis Error: " << err.what() << std::endl;
+        ss << "Cannot list accounts: " << err.what();
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    accounts.reserve(accNums.size());
+
+    // loader threads claim batches, fetch each with one pipelined round trip,
+    // parse, and insert straight into the (sharded) registry. The first
+    // Redis error stops every loader and fails the load
+    std::atomic<size_t> nextBatch{0};
+    std::atomic<size_t> loaded{0};
+    std::atomic<bool> failed{false};
+    std::mutex errorMtx;
+    std::string loadError;
+    size_t batchCount = (accNums.size() + LOAD_BATCH - 1) / LOAD_BATCH;
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), batchCount);
+
+    auto loader = [&](){
+        try{
+            auto pipe = RedisCache::getInstance().newPipeline();
+            std::vector<int> batch;
+            std::vector<std::unique_ptr<Account>> parsed;
+
+            for(size_t b = nextBatch++; b < batchCount && !failed; b = nextBatch++){
+                auto first = accNums.begin() + b * LOAD_BATCH;
+                batch.assign(first, first + std::min(LOAD_BATCH, static_cast<size_t>(accNums.end() - first)));
+                parsed.clear();
+                RedisCache::getInstance().loadAccounts(pipe, batch, parsed);
+                for(auto& acc : parsed){
+                    accounts.insert(std::move(acc));
+                }
+                loaded += parsed.size();
+            }
+        }catch(const sw::redis::Error& err){
+            std::cerr << "Redis Error: " << err.what() << std::endl;
+            std::lock_guard<std::mutex> lock(errorMtx);
+            if(!failed.exchange(true)){
+                loadError = err.what();
+            }
+        }
+    };
+
+    std::vector<std::thread> loaders;
+    for(size_t i = 0; i < threadCount; ++i){
+        loaders.emplace_back(loader);
+    }
+    for(auto& t : loaders){
+        t.join();
+    }
+
+    // a partial table must not be served, replayed onto, or checkpointed
+    if(failed){
+        ss << "Loading accounts failed after " << loaded << " of " << accNums.size() << " accounts: " << loadError;
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    // committed mutations Redis had not seen yet
+    replayJournal();
+    tableLoaded = true;
+    refreshSnapshot(); // so the next start can skip Redis
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = seconds > 0 ? loaded / seconds : 0.0;
+    std::cout << "[Server] Loaded " << loaded << " accounts in " << seconds << " s ("
+              << static_cast<long long>(rate) << " accounts/s)\n";
+
+    ss << "All accounts loaded (" << loaded << " accounts, " << static_cast<long long>(rate) << " accounts/s)";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    return msg;
+}
+
+bool Bank::loadSnapshot(size_t& loaded){
+    Snapshot snapshot;
+    if(snapshotPath.empty() || !snapshot.open(snapshotPath)){
+        return false;
+    }
+
+    // the journal only reaches back to its base; anything older is in
+    // Redis but maybe not in this snapshot
+    if(snapshot.journalLsn() < Journal::getInstance().baseLsn()){
+        std::cout << "[Server] Snapshot predates the last journal checkpoint, loading from Redis\n";
+        return false;
+    }
+
+    snapshot.loadInto(accounts, std::max(1u, std::thread::hardware_concurrency()));
+    loaded = snapshot.size();
+    return true;
+}
+
+void Bank::refreshSnapshot(){
+    if(snapshotPath.empty()){
+        return;
+    }
+    std::thread([this](){
+        writeSnapshot();
+    }).detach();
+}
+
+void Bank::configureSnapshots(const std::string& path, std::chrono::seconds interval){
+    // a snapshot of a partial table would drop accounts on the next start
+    snapshotPath = wholeTableInMemory() ? path : std::string();
+    if(snapshotPath.empty() || interval.count() <= 0){
+        return;
+    }
+
+    std::thread([this, interval](){
+        while(true){
+            std::this_thread::sleep_for(interval);
+            writeSnapshot();
+        }
+    }).detach();
+}
+
+json Bank::writeSnapshot(){
+    std::stringstream ss;
+    json msg;
+
+    if(snapshotPath.empty()){
+        ss << "Snapshots are disabled.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    if(!tableLoaded){
+        ss << "Accounts are not fully loaded, no snapshot written.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    std::lock_guard<std::mutex> lock(snapshotMtx);
+    auto start = std::chrono::steady_clock::now();
+    // read before capturing, so every entry up to it is in the image
+    uint64_t journalLsn = Journal::getInstance().lastLsn();
+    long long written = Snapshot::write(snapshotPath, accounts, journalLsn);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(written < 0){
+        ss << "Failed to write snapshot.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    ss << "Snapshot written (" << written << " accounts in " << seconds << " s)";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    return msg;
+}
+
+std::shared_ptr<Account> Bank::findAccount(int accNum){
+    std::shared_ptr<Account> acc = accounts.find(accNum);
+    if(wholeTableInMemory()){
+        return acc;
+    }
+    if(acc){
+        acc->markUsed();
+        return acc;
+    }
+    return loadOnMiss(accNum);
+}
+
+std::shared_ptr<Account> Bank::loadOnMiss(int accNum){
+    if(!knownAccounts.mayContain(accNum)){
+        ++cacheBloomRejects;
+        return nullptr;
+    }
+
+    std::shared_ptr<Account> acc;
+    {
+        std::lock_guard<std::mutex> stripe(loadStripe(accNum));
+        acc = accounts.find(accNum); // loaded by another request while we waited
+        if(acc){
+            acc->markUsed();
+            return acc;
+        }
+        // an account that is not in memory can only have its delete queued
+        // (queued saves keep an account resident), so Redis is about to lose it
+        if(WriteBehindQueue::getInstance().hasPending(accNum)){
+            ++cacheAbsent;
+            return nullptr;
+        }
+
+        try{
+            acc = RedisCache::getInstance().loadAccount(accNum);
+        }catch(const sw::redis::Error& err){
+            std::cerr << "Redis Error: " << err.what() << std::endl;
+            return nullptr;
+        }
+        if(acc == nullptr){
+            ++cacheAbsent;
+            return nullptr;
+        }
+        acc->markUsed();
+        accounts.insert(acc);
+        ++cacheLoads;
+    }
+    evictIfNeeded();
+    return acc;
+}
+
+void Bank::evictIfNeeded(){
+    size_t resident = accounts.size();
+    if(resident > hotSetCapacity){
+        cacheEvictions += accounts.evict(resident - hotSetCapacity);
+    }
+}
+
+void Bank::configureHotSet(size_t maxAccounts){
+    hotSetCapacity = maxAccounts;
+}
+
+json Bank::cacheStats() const {
+    return {
+        {"capacity", hotSetCapacity},
+        {"resident", accounts.size()},
+        {"loads", cacheLoads.load()},
+        {"bloomRejects", cacheBloomRejects.load()},
+        {"absent", cacheAbsent.load()},
+        {"evictions", cacheEvictions.load()},
+        {"bloomBytes", knownAccounts.bytes()}
+    };
+}
+
+json Bank::needsWholeTable(const char* action) const {
+    std::stringstream ss;
+    json msg;
+    ss << action << " needs the whole table in memory and is not available in hot-set cache mode.";
+    msg["status"] = "failed: ";
+    msg["message"] = ss.str();
+    return msg;
+}
+
+json Bank::applyInterestOne(const json& accJson){
+    json msg;
+
+    int accNum;
+    if(!validateJsonField(accJson, "accountNumber", msg, accNum)){
+        return msg;
+    }
+
+    return applyInterestOne(accNum);
+}
+
+json Bank::applyInterestOne(int accNum){
+    json msg;
+    std::stringstream ss;
+
+    std::shared_ptr<Account> acc = findAccount(accNum);
+    if(acc == nullptr){
+        ss << "Account #" << accNum << " not found.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    if(acc->getType() == AccountType::SAVINGS){
+        msg = static_cast<SavingsAccount&>(*acc).applyInterest();
+        if(!persist(acc)){
+            markNotDurable(msg);
+        }
+        return msg;
+    }else{
+        ss << "This is not a savings account.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+}
+
+json Bank::applyInterestAll(const json& accJson){
+    json msg;
+    std::stringstream ss;
+
+    if(!wholeTableInMemory()){
+        return applyInterestAllHotSet();
+    }
+
+    InterestEngine::Result result = InterestEngine::applyAll(accounts, std::max(1u, std::thread::hardware_concurrency()));
+    // one commit and one enqueue so the updates leave in pipelined batches
+    bool durable = persist(result.updated);
+
+    double rate = result.seconds > 0 ? result.accounts / result.seconds : 0.0;
+    ss << "Interest applied to all (" << result.accounts << " accounts, " << static_cast<long long>(rate) << " accounts/s)";
+    if(result.overflowed > 0){
+        ss << "; " << result.overflowed << " left unchanged, their balance would overflow";
+    }
+    msg["status"] = result.overflowed == 0 ? "success: " : "failed: ";
+    msg["message"] = ss.str();
+    if(!durable){
+        markNotDurable(msg);
+    }
+    return msg;
+}
+
+// Walks every account in Redis in batches: load (evicting as it goes),
+// apply interest under ascending locks, persist, and let the batch reach
+// Redis so it can be evicted before the next one comes in
+json Bank::applyInterestAllHotSet(){
+    constexpr size_t BATCH = 1000;
+    json msg;
+    std::stringstream ss;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<int> accNums;
+    try{
+        // once the queue is drained Redis lists every account created so far
+        WriteBehindQueue::getInstance().flush();
+        accNums = RedisCache::getInstance().getAllAccountNumbers();
+    }catch(const sw::redis::Error& err){
+        ss << "Cannot list accounts: " << err.what();
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    std::sort(accNums.begin(), accNums.end()); // the lock order for multi-account work
+
+    size_t applied = 0;
+    size_t overflowed = 0;
+    bool durable = true;
+    std::vector<std::shared_ptr<Account>> savings;
+    std::vector<Money> balances;
+    std::vector<Rate> rates;
+    for(size_t begin = 0; begin < accNums.size(); begin += BATCH){
+        savings.clear();
+        for(size_t i = begin; i < std::min(accNums.size(), begin + BATCH); ++i){
+            std::shared_ptr<Account> acc = findAccount(accNums[i]);
+            if(acc && acc->getType() == AccountType::SAVINGS){
+                savings.push_back(std::move(acc));
+            }
+        }
+
+        {
+            std::vector<std::unique_lock<std::mutex>> locks;
+            balances.resize(savings.size());
+            rates.resize(savings.size());
+            for(size_t i = 0; i < savings.size(); ++i){
+                locks.push_back(savings[i]->lock());
+                balances[i] = savings[i]->getBalanceLocked();
+                rates[i] = static_cast<const SavingsAccount&>(*savings[i]).getInterestRateLocked();
+            }
+            overflowed += InterestEngine::applyKernel(balances.data(), rates.data(), savings.size());
+            for(size_t i = 0; i < savings.size(); ++i){
+                savings[i]->setBalanceLocked(balances[i]);
+            }
+        }
+
+        durable = persist(savings) && durable;
+        applied += savings.size();
+        savings.clear();
+        WriteBehindQueue::getInstance().flush();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = seconds > 0 ? applied / seconds : 0.0;
+    ss << "Interest applied to all (" << applied << " accounts, " << static_cast<long long>(rate) << " accounts/s)";
+    if(overflowed > 0){
+        ss << "; " << overflowed << " left unchanged, their balance would overflow";
+    }
+    msg["status"] = overflowed == 0 ? "success: " : "failed: ";
+    msg["message"] = ss.str();
+    if(!durable){
+        markNotDurable(msg);
+    }
+    return msg;
+}
+
+json Bank::exportAllAccountsToFile(const json& accJson) const {
+    std::stringstream ss;
+    json msg;
+    ExportFormat format = ExportFormat::JSON;
+    std::string path = accJson.value("path", std::string("accounts_export.json"));
+
+    if(!AccountExporter::parseFormat(accJson.value("format", std::string("json")), format)){
+        ss << "Unknown export format. Use json, ndjson or csv.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    if(path.empty()){
+        ss << "Export path is empty.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    return exportAllAccountsToFile(format, path);
+}
+
+json Bank::exportAllAccountsToFile(ExportFormat format, const std::string& path) const {
+    std::stringstream ss;
+    json msg;
+
+    if(!wholeTableInMemory()){
+        return needsWholeTable("EXPORT_JSON");
+    }
+
+    // exports the in-memory table, which is ahead of Redis, so no flush first
+    std::string error;
+    uint64_t id = AccountExporter::getInstance().start(accounts, format, path, error);
+    if(id == 0){
+        msg["status"] = "failed: ";
+        msg["message"] = error;
+        return msg;
+    }
+    ss << "Export #" << id << " started (" << AccountExporter::formatName(format) << " to " << path << ")";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    msg["jobId"] = id;
+    return msg;
+}
+
+json Bank::exportStatus(const json& accJson) const {
+    std::stringstream ss;
+    json msg;
+    int id = 0;
+
+    if(accJson.contains("jobId") && !validateJsonField(accJson, "jobId", msg, id)){
+        return msg;
+    }
+
+    json job;
+    if(id < 0 || !AccountExporter::getInstance().status(static_cast<uint64_t>(id), job)){
+        ss << "Export #" << id << " not found.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    ss << "Export #" << job["jobId"].get<uint64_t>() << " " << job["state"].get<std::string>() << ": "
+       << job["exported"].get<size_t>() << "/" << job["total"].get<size_t>() << " accounts to " << job["path"].get<std::string>();
+    if(job.contains("error")){
+        ss << " (" << job["error"].get<std::string>() << ")";
+    }
+    msg["status"] = job["state"] == "failed" ? "failed: " : "success: ";
+    msg["message"] = ss.str();
+    msg["export"] = std::move(job);
+    return msg;
+}
+
+json Bank::createAccountFromJson(const json& acc){
+    std::string name, typeName;
     int accNum;
-    double balance;
+    Money balance;
     std::stringstream ss;
     json msg;
 
     if(!validateJsonField(acc, "accountNumber", msg, accNum) ||
        !validateJsonField(acc, "balance", msg, balance) ||
        !validateJsonField(acc, "holderName", msg, name) ||
-       !validateJsonField(acc, "accountType", msg, accountType)){
+       !validateJsonField(acc, "accountType", msg, typeName)){
        return msg;
     }
 
+    AccountType accountType;
+    if(!parseAccountType(typeName, accountType)){
+        ss << "Unkown account type. Account creation failed.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
     if(accountExists(accNum)){
         ss << "Account #" << accNum << " already exists.";
         msg["status"] = "failed: ";
@@ -471,46 +1186,136 @@ json Bank::createAccountFromJson(const json& acc){
         return msg;
     }
 
-    std::unique_ptr<Account> newAcc;
+    Rate rate = 0;
+    int overdraft = 0;
 
-    if(accountType == "SAVINGS"){
-        double rate;
-        if(!validateJsonField(acc, "interestRate", msg, rate)){
+    if(accountType == AccountType::SAVINGS){
+        if(!validateRateField(acc, "interestRate", msg, rate)){
             return msg;
         }
-        newAcc = std::make_unique<SavingsAccount>(accNum, name, balance, rate);
-    }else if(accountType == "CHECKING"){
-        int overdraft;
+    }else{
         if(!validateJsonField(acc, "overdraftLimit", msg, overdraft)){
             return msg;
         }
-        newAcc = std::make_unique<CheckingAccount>(accNum, name, balance, overdraft);
-    }else{
-        ss << "Unkown account type. Account creation failed.";
+    }
+
+    return createAccount(accountType, accNum, name, balance, rate, overdraft);
+}
+
+json Bank::createAccount(AccountType accountType, int accNum, const std::string& name, Money balance, Rate rate, int overdraft){
+    std::stringstream ss;
+    json msg;
+    std::shared_ptr<Account> newAcc;
+
+    if(!holderNameFits(name, msg)){
+        return msg;
+    }
+
+    // in hot-set mode the number may belong to an account that is only in Redis
+    if(!wholeTableInMemory() && findAccount(accNum)){
+        ss << "Account #" << accNum << " already exists.";
         msg["status"] = "failed: ";
         msg["message"] = ss.str();
         return msg;
     }
 
-    accounts.push_back(std::move(newAcc));
-    RedisCache::getInstance().saveAccount(*accounts.back());
+    if(accountType == AccountType::SAVINGS){
+        newAcc = std::make_shared<SavingsAccount>(accNum, name, balance, rate);
+    }else{
+        newAcc = std::make_shared<CheckingAccount>(accNum, name, balance, overdraft);
+    }
+
+    // insert re-checks under the shard lock in case another client raced us;
+    // the gate orders it with DELETE_ALL, which closes what it finds
+    bool inserted;
+    {
+        std::shared_lock<std::shared_mutex> gate(checkpointGate);
+        inserted = accounts.insert(newAcc);
+    }
+    if(!inserted){
+        ss << "Account #" << accNum << " already exists.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+    knownAccounts.add(accNum);
+    bool durable = persist(newAcc);
+    if(!wholeTableInMemory()){
+        evictIfNeeded();
+    }
 
     ss << "Account #" << accNum << " created";
     msg["status"] = "success: ";
     msg["message"] = ss.str();
+    if(!durable){
+        markNotDurable(msg);
+    }
     return msg;
 }
 
+// A wipe rather than a close per account: Redis loses the keys in one
+// pipelined round trip, and memory, journal and snapshot are reset rather
+// than told about each account. The exclusive checkpoint gate keeps every
+// mutation (and create) out of the journal and the queue meanwhile. Redis
+// goes first: if it cannot be wiped nothing else is touched, and once it
+// is, the accounts are closed so requests that started earlier drop their
+// updates instead of persisting them afterwards.
 json Bank::deleteAllAccounts(){
     std::stringstream ss;
     json msg;
-    size_t accTotal= accounts.size();
-    
-    for(auto& acc : accounts){
-        RedisCache::getInstance().deleteAccount(acc->getAccountNumber());
+    size_t inMemory = 0;
+    size_t inRedis = 0;
+
+    {
+        std::unique_lock<std::shared_mutex> gate(checkpointGate);
+        // no miss may bring an account back from Redis either
+        std::vector<std::unique_lock<std::mutex>> stripes;
+        if(!wholeTableInMemory()){
+            for(std::mutex& stripe : loadStripes){
+                stripes.emplace_back(stripe);
+            }
+        }
+
+        // nothing can be queued while the gate is held, so after this no
+        // write can land after the wipe (a batch in flight would)
+        if(!WriteBehindQueue::getInstance().flush()){
+            ss << "Redis did not take the queued writes; nothing was deleted.";
+            msg["status"] = "failed: ";
+            msg["message"] = ss.str();
+            return msg;
+        }
+
+        try{
+            inRedis = RedisCache::getInstance().deleteAllAccounts();
+        }catch(const sw::redis::Error& err){
+            // memory, journal and snapshot still agree with each other
+            std::cerr << "Redis Error: " << err.what() << std::endl;
+            ss << "Redis could not be wiped (" << err.what() << "); nothing else was deleted, retry DELETE_ALL.";
+            msg["status"] = "failed: ";
+            msg["message"] = ss.str();
+            return msg;
+        }
+
+        accounts.forEach([](const std::shared_ptr<Account>& acc){
+            acc->markClosed();
+        });
+
+        // until the new one is written, the next start loads from Redis
+        std::lock_guard<std::mutex> snapshotLock(snapshotMtx);
+        if(!snapshotPath.empty()){
+            std::remove(snapshotPath.c_str());
+        }
+        Journal::getInstance().reset();
+
+        inMemory = accounts.size();
+        accounts.clear();
+        knownAccounts.clear();
+        if(!snapshotPath.empty()){
+            Snapshot::write(snapshotPath, accounts, Journal::getInstance().lastLsn());
+        }
     }
 
-    ss << "All accounts deleted";
+    ss << "All accounts deleted (" << std::max(inMemory, inRedis) << " accounts)";
     msg["status"] = "success: ";
     msg["message"] = ss.str();
     return msg;
@@ -518,9 +1323,8 @@ json Bank::deleteAllAccounts(){
 
 json Bank::transfer(const json& accJson){
     int accNum1, accNum2;
-    double amount;
+    Money amount;
     json msg;
-    std::stringstream ss;
 
     if(!validateJsonField(accJson, "accountNumber1", msg, accNum1)){
         return msg;
@@ -534,8 +1338,29 @@ json Bank::transfer(const json& accJson){
         return msg;
     }
 
-    Account* acc1 = findAccount(accNum1);
-    Account* acc2 = findAccount(accNum2);
+    return transfer(accNum1, accNum2, amount);
+}
+
+json Bank::transfer(int accNum1, int accNum2, Money amount){
+    json msg;
+    std::stringstream ss;
+
+    if(amount < 0){
+        ss << "Cannot transfer negative amount.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    if(accNum1 == accNum2){
+        ss << "Cannot transfer to the same account.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    std::shared_ptr<Account> acc1 = findAccount(accNum1);
+    std::shared_ptr<Account> acc2 = findAccount(accNum2);
 
     if(acc1 == nullptr){
         ss << "Account #" << accNum1 << " not found";
@@ -549,15 +1374,333 @@ json Bank::transfer(const json& accJson){
         return msg;
     }
 
-    msg = acc2->withdraw(amount);
+    {
+        std::shared_lock<std::shared_mutex> gate(checkpointGate);
+        uint64_t lsn = 0;
+        {
+            // both legs under both locks, taken in ascending account number order
+            Account& first = accNum1 < accNum2 ? *acc1 : *acc2;
+            Account& second = accNum1 < accNum2 ? *acc2 : *acc1;
+            std::unique_lock<std::mutex> firstLock = first.lock();
+            std::unique_lock<std::mutex> secondLock = second.lock();
+            msg = transferLocked(*acc1, *acc2, amount);
+
+            if(msg["status"] == "failed: "){
+                return msg;
+            }
+            acc1->markDirtyLocked();
+            acc2->markDirtyLocked();
+            // one journal entry, so replay applies both legs or neither
+            lsn = Journal::getInstance().append({
+                JournalRecord{JournalOp::SAVE, acc1->imageLocked()},
+                JournalRecord{JournalOp::SAVE, acc2->imageLocked()}
+            });
+        }
+        if(!Journal::getInstance().commit(lsn)){
+            markNotDurable(msg);
+        }
 
-    if(msg["status"] == "failed: "){
+        // one enqueue so both accounts leave in the same pipelined flush
+        WriteBehindQueue::getInstance().enqueueSaves({acc1, acc2});
+    }
+    checkpointIfNeeded();
+    return msg;
+}
+
+json Bank::transferLocked(Account& to, Account& from, Money amount){
+    std::stringstream ss;
+    json msg;
+
+    // closed between lookup and locking
+    if(to.isClosed() || from.isClosed()){
+        ss << "Account #" << (to.isClosed() ? to : from).getAccountNumber() << " not found";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
         return msg;
     }
 
-    msg.clear();
-    acc1->deposit(amount);
+    if(!from.canWithdrawLocked(amount)){
+        ss << "Insufficient funds in account #" << from.getAccountNumber() << ".";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    Money toBalance;
+    if(!money::add(to.getBalanceLocked(), amount, toBalance)){
+        ss << "Balance of account #" << to.getAccountNumber() << " would overflow.";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    from.setBalanceLocked(from.getBalanceLocked() - amount);
+    to.setBalanceLocked(toBalance);
+
     msg["status"] = "success: ";
     msg["message"] = "Transfer successful";
     return msg;
-}
\ No newline at end of file
+}
+
+json Bank::transferBatch(const json& accJson){
+    json msg;
+    std::stringstream ss;
+
+    if(!accJson.contains("transfers") || !accJson["transfers"].is_array()){
+        ss << "Missing field 'transfers'";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    struct TransferOp{
+        bool valid = false;
+        int to = 0;
+        int from = 0;
+        Money amount = 0;
+    };
+
+    const json& transfers = accJson["transfers"];
+    json results = json::array();
+    std::vector<TransferOp> ops(transfers.size());
+    std::vector<int> accNums;
+    accNums.reserve(transfers.size() * 2);
+
+    // validate everything up front; invalid items get their result now
+    for(size_t i = 0; i < transfers.size(); ++i){
+        const json& item = transfers[i];
+        TransferOp& op = ops[i];
+        json itemMsg;
+        results.push_back(nullptr);
+
+        op.valid = validateJsonField(item, "accountNumber1", itemMsg, op.to) &&
+                   validateJsonField(item, "accountNumber2", itemMsg, op.from) &&
+                   validateJsonField(item, "amount", itemMsg, op.amount);
+        if(op.valid && op.amount < 0){
+            op.valid = false;
+            itemMsg["message"] = "Cannot transfer negative amount.";
+        }else if(op.valid && op.to == op.from){
+            op.valid = false;
+            itemMsg["message"] = "Cannot transfer to the same account.";
+        }
+
+        if(op.valid){
+            accNums.push_back(op.to);
+            accNums.push_back(op.from);
+        }else{
+            results[i] = json::array({0, itemMsg["message"]});
+        }
+    }
+
+    // every account is looked up and locked once for the whole batch rather
+    // than twice per transfer; ascending order is the global lock order
+    std::sort(accNums.begin(), accNums.end());
+    accNums.erase(std::unique(accNums.begin(), accNums.end()), accNums.end());
+
+    std::shared_lock<std::shared_mutex> gate(checkpointGate);
+    std::vector<std::shared_ptr<Account>> involved;
+    std::vector<std::unique_lock<std::mutex>> locks;
+    involved.reserve(accNums.size());
+    locks.reserve(accNums.size());
+    for(int accNum : accNums){
+        involved.push_back(findAccount(accNum));
+        if(involved.back()){
+            locks.push_back(involved.back()->lock());
+        }
+    }
+
+    auto indexOf = [&accNums](int accNum){
+        return static_cast<size_t>(std::lower_bound(accNums.begin(), accNums.end(), accNum) - accNums.begin());
+    };
+
+    // settle in request order so each transfer sees the balances left by
+    // the ones before it
+    std::vector<char> touched(involved.size(), 0);
+    for(size_t i = 0; i < ops.size(); ++i){
+        const TransferOp& op = ops[i];
+        if(!op.valid){
+            continue;
+        }
+
+        size_t to = indexOf(op.to);
+        size_t from = indexOf(op.from);
+        if(!involved[to] || !involved[from]){
+            std::stringstream notFound;
+            notFound << "Account #" << (involved[to] ? op.from : op.to) << " not found";
+            results[i] = json::array({0, notFound.str()});
+            continue;
+        }
+
+        json itemMsg = transferLocked(*involved[to], *involved[from], op.amount);
+        bool ok = itemMsg["status"] != "failed: ";
+        if(ok){
+            touched[to] = 1;
+            touched[from] = 1;
+        }
+        results[i] = json::array({ok ? 1 : 0, itemMsg["message"]});
+    }
+
+    std::vector<std::shared_ptr<Account>> modified;
+    std::vector<JournalRecord> images;
+    for(size_t i = 0; i < involved.size(); ++i){
+        if(touched[i]){
+            involved[i]->markDirtyLocked();
+            images.push_back(JournalRecord{JournalOp::SAVE, involved[i]->imageLocked()});
+            modified.push_back(std::move(involved[i]));
+        }
+    }
+    // the whole batch is one journal entry, replayed all or nothing
+    uint64_t lsn = Journal::getInstance().append(images);
+    locks.clear(); // unlock
+    bool durable = Journal::getInstance().commit(lsn);
+
+    // queue every touched account together so they go out in one pipelined flush
+    WriteBehindQueue::getInstance().enqueueSaves(modified);
+    gate.unlock();
+    checkpointIfNeeded();
+
+    ss << "Batch of " << transfers.size() << " transfers settled";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    msg["results"] = std::move(results);
+    if(!durable){
+        markNotDurable(msg);
+    }
+    return msg;
+}
+
+json Bank::batch(const json& accJson){
+    json msg;
+    std::stringstream ss;
+
+    if(!accJson.contains("operations") || !accJson["operations"].is_array()){
+        ss << "Missing field 'operations'";
+        msg["status"] = "failed: ";
+        msg["message"] = ss.str();
+        return msg;
+    }
+
+    struct BatchOp{
+        size_t index = 0;
+        std::string action;
+        int accNum = 0;
+        Money amount = 0;
+        std::string newName;
+        Money newBalance = 0;
+        Rate newInterestRate = 0;
+        int newOverdraftLimit = 0;
+    };
+
+    const json& operations = accJson["operations"];
+    json results = json::array();
+    std::vector<BatchOp> ops;
+    ops.reserve(operations.size());
+
+    // validate everything up front; invalid items get their result now
+    for(size_t i = 0; i < operations.size(); ++i){
+        const json& op = operations[i];
+        json itemMsg;
+        BatchOp parsed;
+        parsed.index = i;
+        parsed.action = op.value("action", std::string());
+        results.push_back(nullptr);
+
+        bool valid = validateJsonField(op, "accountNumber", itemMsg, parsed.accNum);
+        if(valid && (parsed.action == "DEPOSIT" || parsed.action == "WITHDRAW")){
+            valid = validateJsonField(op, "amount", itemMsg, parsed.amount);
+        }else if(valid && parsed.action == "MODIFY"){
+            valid = validateJsonField(op, "holderName", itemMsg, parsed.newName) &&
+                    validateJsonField(op, "balance", itemMsg, parsed.newBalance);
+            // rate/limit are optional here; an absent field leaves it unchanged
+            if(valid && op.contains("interestRate")){
+                valid = validateRateField(op, "interestRate", itemMsg, parsed.newInterestRate);
+            }
+            if(valid && op.contains("overdraftLimit")){
+                valid = validateJsonField(op, "overdraftLimit", itemMsg, parsed.newOverdraftLimit);
+            }
+        }else if(valid){
+            valid = false;
+            itemMsg["message"] = "Unsupported batch action '" + parsed.action + "'";
+        }
+
+        if(valid){
+            ops.push_back(std::move(parsed));
+        }else{
+            results[i] = json::array({0, itemMsg["message"]});
+        }
+    }
+
+    // group by account so each account is looked up once and its operations
+    // run back to back; stable sort keeps per-account request order
+    std::stable_sort(ops.begin(), ops.end(), [](const BatchOp& a, const BatchOp& b){
+        return a.accNum < b.accNum;
+    });
+
+    // like TRANSFER_BATCH: every account stays locked (in ascending order)
+    // until the batch is journaled, so a CLOSE can not slip in between its
+    // operations and nothing is visible before it is in the journal
+    std::shared_lock<std::shared_mutex> gate(checkpointGate);
+    std::vector<std::shared_ptr<Account>> touched;
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for(size_t i = 0; i < ops.size();){
+        int accNum = ops[i].accNum;
+        std::shared_ptr<Account> acc = findAccount(accNum);
+        bool modified = false;
+        if(acc){
+            locks.push_back(acc->lock());
+        }
+
+        for(; i < ops.size() && ops[i].accNum == accNum; ++i){
+            const BatchOp& op = ops[i];
+            json itemMsg;
+
+            if(acc == nullptr){
+                std::stringstream notFound;
+                notFound << "Account #" << accNum << " not found.";
+                results[op.index] = json::array({0, notFound.str()});
+                continue;
+            }
+
+            if(op.action == "DEPOSIT"){
+                itemMsg = depositTo(*acc, op.amount);
+            }else if(op.action == "WITHDRAW"){
+                itemMsg = withdrawFrom(*acc, op.amount);
+            }else{
+                itemMsg = applyModification(*acc, op.newName, op.newBalance, op.newInterestRate, op.newOverdraftLimit);
+            }
+
+            bool ok = itemMsg["status"] != "failed: ";
+            modified = modified || ok;
+            results[op.index] = json::array({ok ? 1 : 0, itemMsg["message"]});
+        }
+
+        if(modified){
+            touched.push_back(acc);
+        }
+    }
+
+    std::vector<JournalRecord> images;
+    images.reserve(touched.size());
+    for(const auto& acc : touched){
+        acc->markDirtyLocked();
+        images.push_back(JournalRecord{JournalOp::SAVE, acc->imageLocked()});
+    }
+    // the whole batch is one journal entry, replayed all or nothing
+    uint64_t lsn = Journal::getInstance().append(images);
+    locks.clear(); // unlock
+    bool durable = Journal::getInstance().commit(lsn);
+
+    // queue every touched account together so they go out in one pipelined flush
+    WriteBehindQueue::getInstance().enqueueSaves(touched);
+    gate.unlock();
+    checkpointIfNeeded();
+
+    ss << "Batch of " << operations.size() << " operations processed";
+    msg["status"] = "success: ";
+    msg["message"] = ss.str();
+    msg["results"] = std::move(results);
+    if(!durable){
+        markNotDurable(msg);
+    }
+    return msg;
+}
@@ -0,0 +1,272 @@
+#include "BinaryProtocol.hpp"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+    void putU8(std::string& out, uint8_t v){
+        out.push_back(static_cast<char>(v));
+    }
+
+    void putU16(std::string& out, uint16_t v){
+        out.push_back(static_cast<char>(v));
+        out.push_back(static_cast<char>(v >> 8));
+    }
+
+    void putU32(std::string& out, uint32_t v){
+        for(int i = 0; i < 4; ++i){
+            out.push_back(static_cast<char>(v >> (8 * i)));
+        }
+    }
+
+    void putU64(std::string& out, uint64_t v){
+        for(int i = 0; i < 8; ++i){
+            out.push_back(static_cast<char>(v >> (8 * i)));
+        }
+    }
+
+    void putI64(std::string& out, int64_t v){
+        putU64(out, static_cast<uint64_t>(v));
+    }
+
+    void putStr(std::string& out, std::string_view v){
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(v.size(), UINT16_MAX));
+        putU16(out, length);
+        out.append(v.data(), length);
+    }
+
+    // Bounds-checked little-endian reader over one frame
+    class Reader{
+    public:
+        explicit Reader(std::string_view data) : data(data) {}
+
+        bool u8(uint8_t& v){
+            if(!need(1)) return false;
+            v = static_cast<uint8_t>(data[pos++]);
+            return true;
+        }
+
+        bool u16(uint16_t& v){
+            uint64_t wide;
+            if(!little(2, wide)) return false;
+            v = static_cast<uint16_t>(wide);
+            return true;
+        }
+
+        bool u32(uint32_t& v){
+            uint64_t wide;
+            if(!little(4, wide)) return false;
+            v = static_cast<uint32_t>(wide);
+            return true;
+        }
+
+        bool i32(int32_t& v){
+            uint32_t bits;
+            if(!u32(bits)) return false;
+            v = static_cast<int32_t>(bits);
+            return true;
+        }
+
+        bool i64(int64_t& v){
+            uint64_t bits;
+            if(!little(8, bits)) return false;
+            v = static_cast<int64_t>(bits);
+            return true;
+        }
+
+        bool str(std::string_view& v){
+            uint16_t length;
+            if(!u16(length) || !need(length)) return false;
+            v = data.substr(pos, length);
+            pos += length;
+            return true;
+        }
+
+        bool done() const {
+            return pos == data.size();
+        }
+    private:
+        bool need(size_t n) const {
+            return data.size() - pos >= n;
+        }
+
+        bool little(size_t n, uint64_t& v){
+            if(!need(n)) return false;
+            v = 0;
+            for(size_t i = 0; i < n; ++i){
+                v |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+            }
+            pos += n;
+            return true;
+        }
+
+        std::string_view data;
+        size_t pos = 0;
+    };
+
+    bool validKind(uint8_t kind){
+        return kind == static_cast<uint8_t>(AccountKind::SAVINGS) || kind == static_cast<uint8_t>(AccountKind::CHECKING);
+    }
+}
+
+void encodeRequest(const BinaryRequest& req, std::string& out){
+    putU8(out, static_cast<uint8_t>(req.op));
+
+    switch(req.op){
+        case Opcode::CREATE:
+            putU8(out, static_cast<uint8_t>(req.accountType));
+            putU32(out, static_cast<uint32_t>(req.accountNumber));
+            putI64(out, req.balance);
+            putI64(out, req.rateOrLimit);
+            putStr(out, req.holderName);
+            break;
+        case Opcode::MODIFY:
+            putU32(out, static_cast<uint32_t>(req.accountNumber));
+            putI64(out, req.balance);
+            putI64(out, req.rateOrLimit);
+            putStr(out, req.holderName);
+            break;
+        case Opcode::DEPOSIT:
+        case Opcode::WITHDRAW:
+            putU32(out, static_cast<uint32_t>(req.accountNumber));
+            putI64(out, req.amount);
+            break;
+        case Opcode::TRANSFER:
+            putU32(out, static_cast<uint32_t>(req.accountNumber));
+            putU32(out, static_cast<uint32_t>(req.accountNumber2));
+            putI64(out, req.amount);
+            break;
+        case Opcode::DELETE:
+        case Opcode::DISPLAY_ONE:
+        case Opcode::APPLY_INTEREST_ONE:
+            putU32(out, static_cast<uint32_t>(req.accountNumber));
+            break;
+        case Opcode::DISPLAY_ALL:
+            putU8(out, static_cast<uint8_t>(req.accountType));
+            putU64(out, req.cursor);
+            putU32(out, req.limit);
+            break;
+        default:
+            break;
+    }
+}
+
+bool decodeRequest(std::string_view payload, BinaryRequest& req){
+    Reader in(payload);
+    uint8_t op;
+    if(!in.u8(op)){
+        return false;
+    }
+    req.op = static_cast<Opcode>(op);
+
+    bool ok = true;
+    switch(req.op){
+        case Opcode::CREATE: {
+            uint8_t kind = 0;
+            ok = in.u8(kind) && validKind(kind) && in.i32(req.accountNumber) &&
+                 in.i64(req.balance) && in.i64(req.rateOrLimit) && in.str(req.holderName);
+            req.accountType = static_cast<AccountKind>(kind);
+            break;
+        }
+        case Opcode::MODIFY:
+            ok = in.i32(req.accountNumber) && in.i64(req.balance) &&
+                 in.i64(req.rateOrLimit) && in.str(req.holderName);
+            break;
+        case Opcode::DEPOSIT:
+        case Opcode::WITHDRAW:
+            ok = in.i32(req.accountNumber) && in.i64(req.amount);
+            break;
+        case Opcode::TRANSFER:
+            ok = in.i32(req.accountNumber) && in.i32(req.accountNumber2) && in.i64(req.amount);
+            break;
+        case Opcode::DELETE:
+        case Opcode::DISPLAY_ONE:
+        case Opcode::APPLY_INTEREST_ONE:
+            ok = in.i32(req.accountNumber);
+            break;
+        case Opcode::DISPLAY_ALL: {
+            req.accountType = AccountKind::ANY;
+            if(in.done()){
+                break; // older clients send no paging fields
+            }
+            uint8_t kind = 0;
+            int64_t cursor = 0;
+            ok = in.u8(kind) && (kind == 0 || validKind(kind)) && in.i64(cursor) && in.u32(req.limit);
+            req.accountType = static_cast<AccountKind>(kind);
+            req.cursor = static_cast<uint64_t>(cursor);
+            break;
+        }
+        case Opcode::APPLY_INTEREST_ALL:
+        case Opcode::DELETE_ALL:
+        case Opcode::EXPORT_JSON:
+        case Opcode::EXIT:
+            break;
+        default:
+            return false;
+    }
+
+    return ok && in.done();
+}
+
+void encodeResponse(bool success, std::string_view message, std::string& out){
+    putU8(out, success ? 0 : 1);
+    out.append(message.data(), message.size());
+}
+
+bool decodeResponse(std::string_view payload, bool& success, std::string_view& message){
+    if(payload.empty()){
+        return false;
+    }
+    success = payload[0] == 0;
+    message = payload.substr(1);
+    return true;
+}
+
+void encodeAccountList(const std::vector<BinaryAccount>& accounts, uint64_t nextCursor, std::string& out){
+    putU8(out, 0);
+    putU64(out, nextCursor);
+    putU32(out, static_cast<uint32_t>(accounts.size()));
+    for(const auto& acc : accounts){
+        putU8(out, static_cast<uint8_t>(acc.accountType));
+        putU32(out, static_cast<uint32_t>(acc.accountNumber));
+        putI64(out, acc.balance);
+        putI64(out, acc.rateOrLimit);
+        putStr(out, acc.holderName);
+    }
+}
+
+bool decodeAccountList(std::string_view payload, std::vector<BinaryAccount>& accounts, uint64_t& nextCursor){
+    Reader in(payload);
+    uint8_t status;
+    int64_t cursor;
+    uint32_t count;
+    if(!in.u8(status) || status != 0 || !in.i64(cursor) || !in.u32(count)){
+        return false;
+    }
+    nextCursor = static_cast<uint64_t>(cursor);
+
+    accounts.clear();
+    for(uint32_t i = 0; i < count; ++i){
+        BinaryAccount acc;
+        uint8_t kind;
+        std::string_view name;
+        if(!in.u8(kind) || !validKind(kind) || !in.i32(acc.accountNumber) ||
+           !in.i64(acc.balance) || !in.i64(acc.rateOrLimit) || !in.str(name)){
+            return false;
+        }
+        acc.accountType = static_cast<AccountKind>(kind);
+        acc.holderName = std::string(name);
+        accounts.push_back(std::move(acc));
+    }
+    return in.done();
+}
+
+std::string cursorToString(uint64_t cursor){
+    char buf[16];
+    return std::string(buf, std::to_chars(buf, buf + sizeof(buf), cursor, 16).ptr);
+}
+
+bool parseCursor(std::string_view text, uint64_t& cursor){
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, cursor, 16);
+    return !text.empty() && result.ec == std::errc() && result.ptr == end;
+}
@@ -0,0 +1,53 @@
+#include "BloomFilter.hpp"
+
+namespace {
+    // splitmix64 finalizer; its two halves seed the double hashing
+    uint64_t mix(uint64_t x){
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+}
+
+void BloomFilter::reset(size_t expected){
+    size_t bits = 64;
+    while(bits < expected * BITS_PER_ITEM){
+        bits <<= 1;
+    }
+    words.reset(new std::atomic<uint64_t>[bits / 64]());
+    mask = bits - 1;
+}
+
+void BloomFilter::clear(){
+    for(uint64_t i = 0; words && i <= mask / 64; ++i){
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void BloomFilter::add(int key){
+    if(!words){
+        return;
+    }
+    uint64_t h = mix(static_cast<uint32_t>(key));
+    uint64_t step = (h >> 32) | 1;
+    for(int i = 0; i < PROBES; ++i, h += step){
+        uint64_t bit = h & mask;
+        words[bit / 64].fetch_or(uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+bool BloomFilter::mayContain(int key) const {
+    if(!words){
+        return true;
+    }
+    uint64_t h = mix(static_cast<uint32_t>(key));
+    uint64_t step = (h >> 32) | 1;
+    for(int i = 0; i < PROBES; ++i, h += step){
+        uint64_t bit = h & mask;
+        if(!(words[bit / 64].load(std::memory_order_relaxed) & (uint64_t{1} << (bit % 64)))){
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,12 +1,12 @@
 #include "CheckingAccount.hpp"
 
-json CheckingAccount::withdraw(double amount) {
+json CheckingAccount::withdraw(Money amount) {
     std::lock_guard<std::mutex> lock(mtx);
     std::stringstream ss;
     json msg;
-    if(balance + overdraftLimit - amount >= 0){
+    if(canWithdrawLocked(amount)){
         balance -= amount;
-        ss << "New balance of $" << balance;
+        ss << "New balance of $" << money::toString(balance);
         msg = {
             {"status", "success: "},
             {"message", ss.str()}
@@ -15,7 +15,7 @@ json CheckingAccount::withdraw(double amount) {
     }else{
         ss << "Overdraft limit exceeded.";
         msg = {
-            {"status", "success"},
+            {"status", "failed: "},
             {"message", ss.str()}
         };
         return msg;
@@ -23,9 +23,10 @@ json CheckingAccount::withdraw(double amount) {
 }
 
 json CheckingAccount::display() const {
+    std::lock_guard<std::mutex> lock(mtx);
     std::stringstream ss;
     json msg;
-    ss << "CHECKING " << accountNumber << " " << holderName << " " << balance << " " << overdraftLimit;
+    ss << "CHECKING " << accountNumber << " " << holderName << " " << money::toString(balance) << " " << overdraftLimit;
     msg = {
         {"status", "success: "},
         {"message", ss.str()}
@@ -38,24 +39,18 @@ void CheckingAccount::setOverDraftLimit(int newLimit) {
     overdraftLimit = newLimit;
 }
 
-std::string CheckingAccount::getHolderName() const {
-    return holderName;
-}
-
-std::string CheckingAccount::getAccountType() const {
-    return "CHECKING";
-}
-
 int CheckingAccount::getOverDraftLimit() const {
+    std::lock_guard<std::mutex> lock(mtx);
     return overdraftLimit;
 }
 
 json CheckingAccount::toJson() const {
+    std::lock_guard<std::mutex> lock(mtx);
     return {
         {"accountType", "CHECKING"},
         {"accountNumber", accountNumber},
         {"holderName", holderName},
-        {"balance", balance},
+        {"balance", money::toString(balance)},
         {"overdraftLimit", overdraftLimit}
     };
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "Crc32.hpp"
+#include <array>
+
+namespace {
+    // slicing-by-4 tables, built once
+    struct Crc32Tables{
+        std::array<std::array<uint32_t, 256>, 4> t;
+
+        Crc32Tables(){
+            for(uint32_t i = 0; i < 256; ++i){
+                uint32_t c = i;
+                for(int k = 0; k < 8; ++k){
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[0][i] = c;
+            }
+            for(uint32_t i = 0; i < 256; ++i){
+                for(int s = 1; s < 4; ++s){
+                    t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    const Crc32Tables tables;
+}
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc){
+    const auto* p = static_cast<const uint8_t*>(data);
+    const auto& t = tables.t;
+    crc = ~crc;
+
+    while(size >= 4){
+        crc ^= static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+        crc = t[3][crc & 0xFF] ^ t[2][(crc >> 8) & 0xFF] ^ t[1][(crc >> 16) & 0xFF] ^ t[0][crc >> 24];
+        p += 4;
+        size -= 4;
+    }
+    while(size--){
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
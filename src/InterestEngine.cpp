@@ -0,0 +1,75 @@
+#include "InterestEngine.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+size_t InterestEngine::applyKernel(Money* __restrict balances, const Rate* __restrict rates, size_t count){
+    size_t overflowed = 0;
+    for(size_t i = 0; i < count; ++i){
+        Money interest = 0;
+        bool ok = money::interestOn(balances[i], rates[i], interest) && money::add(balances[i], interest, balances[i]);
+        overflowed += !ok;
+    }
+    return overflowed;
+}
+
+InterestEngine::Result InterestEngine::applyAll(const AccountRegistry& registry, size_t threads){
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextShard{0};
+    std::mutex resultMtx;
+
+    auto worker = [&](){
+        std::vector<std::shared_ptr<Account>> savings;
+        std::vector<std::unique_lock<std::mutex>> locks;
+        std::vector<Money> balances;
+        std::vector<Rate> rates;
+
+        for(size_t shard = nextShard++; shard < AccountRegistry::SHARD_COUNT; shard = nextShard++){
+            savings.clear();
+            for(auto& acc : registry.shardSnapshot(shard)){
+                if(acc->getType() == AccountType::SAVINGS){
+                    savings.push_back(std::move(acc));
+                }
+            }
+
+            // ascending order is the global lock order for multi-account work
+            std::sort(savings.begin(), savings.end(), [](const auto& a, const auto& b){
+                return a->getAccountNumber() < b->getAccountNumber();
+            });
+
+            locks.clear();
+            balances.resize(savings.size());
+            rates.resize(savings.size());
+            for(size_t i = 0; i < savings.size(); ++i){
+                locks.push_back(savings[i]->lock());
+                balances[i] = savings[i]->getBalanceLocked();
+                rates[i] = static_cast<const SavingsAccount&>(*savings[i]).getInterestRateLocked();
+            }
+
+            size_t overflowed = applyKernel(balances.data(), rates.data(), savings.size());
+
+            for(size_t i = 0; i < savings.size(); ++i){
+                savings[i]->setBalanceLocked(balances[i]);
+            }
+            locks.clear(); // unlock
+
+            std::lock_guard<std::mutex> lock(resultMtx);
+            result.accounts += savings.size();
+            result.overflowed += overflowed;
+            result.updated.insert(result.updated.end(), savings.begin(), savings.end());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < std::max<size_t>(1, threads); ++i){
+        workers.emplace_back(worker);
+    }
+    for(auto& t : workers){
+        t.join();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,483 @@
+#include "Journal.hpp"
+#include "Crc32.hpp"
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+namespace {
+    constexpr char MAGIC[8] = {'B', 'A', 'N', 'K', 'J', 'R', 'N', 'L'};
+    constexpr size_t FILE_HEADER_SIZE = 16; // magic, u64 base LSN
+    constexpr size_t ENTRY_HEADER_SIZE = 8; // u32 bodyLength, u32 crc32
+
+    void putU8(std::string& out, uint8_t v){
+        out.push_back(static_cast<char>(v));
+    }
+
+    void putLittle(std::string& out, uint64_t v, size_t bytes){
+        for(size_t i = 0; i < bytes; ++i){
+            out.push_back(static_cast<char>(v >> (8 * i)));
+        }
+    }
+
+    void encodeRecord(JournalOp op, const AccountImage& image, std::string& out){
+        putU8(out, static_cast<uint8_t>(op));
+        putLittle(out, static_cast<uint32_t>(image.accountNumber), 4);
+        if(op == JournalOp::SAVE){
+            // requests cannot set a name longer than MAX_HOLDER_NAME
+            size_t nameLength = image.holderName.size();
+            putU8(out, static_cast<uint8_t>(image.type));
+            putLittle(out, static_cast<uint64_t>(image.balance), 8);
+            putLittle(out, static_cast<uint64_t>(image.rateOrLimit), 8);
+            putLittle(out, nameLength, 2);
+            out.append(image.holderName.data(), nameLength);
+        }
+    }
+
+    // Bounds-checked little-endian reader over one entry body
+    class Reader{
+    public:
+        Reader(const char* data, size_t size) : data(data), size(size) {}
+
+        bool little(size_t bytes, uint64_t& v){
+            if(size - pos < bytes) return false;
+            v = 0;
+            for(size_t i = 0; i < bytes; ++i){
+                v |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+            }
+            pos += bytes;
+            return true;
+        }
+
+        bool bytes(size_t n, std::string& out){
+            if(size - pos < n) return false;
+            out.assign(data + pos, n);
+            pos += n;
+            return true;
+        }
+
+        bool done() const {
+            return pos == size;
+        }
+    private:
+        const char* data;
+        size_t size;
+        size_t pos = 0;
+    };
+
+    bool decodeRecord(Reader& in, JournalRecord& rec){
+        uint64_t op, accNum;
+        if(!in.little(1, op) || !in.little(4, accNum)){
+            return false;
+        }
+        rec.op = static_cast<JournalOp>(op);
+        rec.image = AccountImage();
+        rec.image.accountNumber = static_cast<int32_t>(accNum);
+
+        if(rec.op == JournalOp::DELETE){
+            return true;
+        }
+        if(rec.op != JournalOp::SAVE){
+            return false;
+        }
+
+        uint64_t type, balance, rateOrLimit, nameLength;
+        if(!in.little(1, type) || !in.little(8, balance) || !in.little(8, rateOrLimit) ||
+           !in.little(2, nameLength) || !in.bytes(nameLength, rec.image.holderName)){
+            return false;
+        }
+        if(type != static_cast<uint8_t>(AccountType::SAVINGS) && type != static_cast<uint8_t>(AccountType::CHECKING)){
+            return false;
+        }
+        rec.image.type = static_cast<AccountType>(type);
+        rec.image.balance = static_cast<Money>(balance);
+        rec.image.rateOrLimit = static_cast<int64_t>(rateOrLimit);
+        return true;
+    }
+
+    bool writeAll(int fd, const std::string& data){
+        size_t written = 0;
+        while(written < data.size()){
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if(n == -1){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // makes a rename in the file's directory durable
+    void syncParentDir(const std::string& path){
+        std::string copy = path;
+        int dirFd = ::open(dirname(&copy[0]), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(dirFd >= 0){
+            fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+
+    const char* policyName(FsyncPolicy policy){
+        switch(policy){
+            case FsyncPolicy::NONE: return "none";
+            case FsyncPolicy::GROUP: return "group";
+            case FsyncPolicy::ALWAYS: return "always";
+        }
+        return "unknown";
+    }
+}
+
+Journal::~Journal(){
+    std::lock_guard<std::mutex> lock(mtx);
+    closeLocked();
+}
+
+void Journal::closeLocked(){
+    if(fd >= 0){
+        if(!buffer.empty()){
+            writeAll(fd, buffer);
+            buffer.clear();
+        }
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool Journal::createLocked(uint64_t newBase){
+    std::string header(MAGIC, sizeof(MAGIC));
+    putLittle(header, newBase, 8);
+
+    std::string tmpPath = config.path + ".tmp";
+    int tmpFd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(tmpFd == -1 || !writeAll(tmpFd, header) || fsync(tmpFd) != 0){
+        std::cerr << "Journal: cannot create " << tmpPath << ": " << std::strerror(errno) << "\n";
+        if(tmpFd >= 0){
+            ::close(tmpFd);
+        }
+        return false;
+    }
+    ::close(tmpFd);
+
+    if(std::rename(tmpPath.c_str(), config.path.c_str()) != 0){
+        std::cerr << "Journal: cannot replace " << config.path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    syncParentDir(config.path);
+    return true;
+}
+
+bool Journal::open(const JournalConfig& newConfig){
+    std::unique_lock<std::mutex> lock(mtx);
+    synced.wait(lock, [this]{ return !syncing; });
+    closeLocked();
+
+    config = newConfig;
+    struct stat st;
+    if((::stat(config.path.c_str(), &st) != 0 || st.st_size == 0) && !createLocked(0)){
+        return false;
+    }
+
+    fd = ::open(config.path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    if(fd == -1){
+        std::cerr << "Journal: cannot open " << config.path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    char header[FILE_HEADER_SIZE];
+    if(::pread(fd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+       std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0){
+        std::cerr << "Journal: " << config.path << " is not a journal file\n";
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    Reader baseReader(header + sizeof(MAGIC), 8);
+    baseReader.little(8, base);
+
+    fileBytes = fstat(fd, &st) == 0 ? static_cast<size_t>(st.st_size) : FILE_HEADER_SIZE;
+    nextLsn = std::max(nextLsn, base + 1);
+    appendedLsn = durableLsn = nextLsn - 1;
+    failed = false;
+    entries = records = syncs = syncedEntries = totalSyncUs = maxSyncUs = 0;
+    return true;
+}
+
+bool Journal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return fd >= 0;
+}
+
+template <typename Encode>
+uint64_t Journal::appendEntry(uint32_t count, Encode&& encode){
+    std::lock_guard<std::mutex> lock(mtx);
+    if(fd < 0 || count == 0 || failed){
+        return 0;
+    }
+
+    uint64_t lsn = nextLsn++;
+    size_t start = buffer.size();
+    buffer.append(ENTRY_HEADER_SIZE, '\0'); // patched below
+    putLittle(buffer, lsn, 8);
+    putLittle(buffer, count, 4);
+    encode(buffer);
+
+    size_t bodyLength = buffer.size() - start - ENTRY_HEADER_SIZE;
+    uint32_t crc = crc32(buffer.data() + start + ENTRY_HEADER_SIZE, bodyLength);
+    for(size_t i = 0; i < 4; ++i){
+        buffer[start + i] = static_cast<char>(bodyLength >> (8 * i));
+        buffer[start + 4 + i] = static_cast<char>(crc >> (8 * i));
+    }
+
+    appendedLsn = lsn;
+    ++entries;
+    records += count;
+
+    if(config.policy == FsyncPolicy::ALWAYS){
+        // no sharing: every entry pays for its own write and fdatasync
+        auto syncStart = std::chrono::steady_clock::now();
+        if(!writeAll(fd, buffer) || fdatasync(fd) != 0){
+            failLocked(errno);
+            return lsn; // its commit() reports the failure
+        }
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - syncStart).count();
+        fileBytes += buffer.size();
+        buffer.clear();
+        durableLsn = lsn;
+        ++syncs;
+        ++syncedEntries;
+        totalSyncUs += us;
+        maxSyncUs = std::max(maxSyncUs, us);
+    }
+    return lsn;
+}
+
+uint64_t Journal::append(const std::vector<JournalRecord>& recs){
+    return appendEntry(static_cast<uint32_t>(recs.size()), [&recs](std::string& out){
+        for(const auto& rec : recs){
+            encodeRecord(rec.op, rec.image, out);
+        }
+    });
+}
+
+// encoded straight from the caller's image: no record copy, no vector
+uint64_t Journal::appendSave(const AccountImage& image){
+    return appendEntry(1, [&image](std::string& out){
+        encodeRecord(JournalOp::SAVE, image, out);
+    });
+}
+
+uint64_t Journal::appendDelete(int accNum){
+    return appendEntry(1, [accNum](std::string& out){
+        AccountImage image;
+        image.accountNumber = accNum;
+        encodeRecord(JournalOp::DELETE, image, out);
+    });
+}
+
+bool Journal::commit(uint64_t lsn){
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // leader/follower group commit: whoever finds no sync in flight writes
+    // and syncs everything appended so far; the rest wait for it
+    while(durableLsn < lsn && fd >= 0 && !failed){
+        if(syncing){
+            synced.wait(lock);
+            continue;
+        }
+        syncing = true;
+
+        if(config.policy == FsyncPolicy::GROUP && config.groupDelay.count() > 0){
+            lock.unlock();
+            std::this_thread::sleep_for(config.groupDelay); // let followers join
+            lock.lock();
+        }
+
+        // swap buffers rather than move, so both keep their capacity and
+        // steady-state appends never allocate
+        std::string& batch = writing;
+        batch.swap(buffer);
+        uint64_t upto = appendedLsn;
+        uint64_t batchEntries = upto - durableLsn;
+        bool sync = config.policy != FsyncPolicy::NONE;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = writeAll(fd, batch) && (!sync || fdatasync(fd) == 0);
+        int err = errno;
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        fileBytes += batch.size();
+        batch.clear();
+        if(ok){
+            durableLsn = upto;
+        }else{
+            failLocked(err);
+        }
+        syncing = false;
+        if(sync){
+            ++syncs;
+            syncedEntries += batchEntries;
+            totalSyncUs += us;
+            maxSyncUs = std::max(maxSyncUs, us);
+        }
+        synced.notify_all();
+    }
+    // lsn 0 is an append that was refused, which is only fine when the
+    // journal is off rather than failed
+    return failed ? lsn != 0 && lsn <= durableLsn : true;
+}
+
+void Journal::failLocked(int err){
+    if(!failed){
+        std::cerr << "Journal: write failed: " << std::strerror(err) << "; refusing commits until the next checkpoint\n";
+    }
+    // a failed fdatasync may have dropped the dirty pages, so retrying the
+    // same file could report success for data that never reached the disk
+    failed = true;
+    buffer.clear();
+}
+
+size_t Journal::replay(const std::function<void(const JournalRecord&)>& apply){
+    std::unique_lock<std::mutex> lock(mtx);
+    if(fd < 0){
+        return 0;
+    }
+
+    std::string data;
+    data.resize(fileBytes);
+    size_t got = 0;
+    while(got < data.size()){
+        ssize_t n = ::pread(fd, &data[got], data.size() - got, static_cast<off_t>(got));
+        if(n <= 0){
+            if(n == -1 && errno == EINTR){
+                continue;
+            }
+            break;
+        }
+        got += static_cast<size_t>(n);
+    }
+    data.resize(got);
+
+    size_t pos = FILE_HEADER_SIZE;
+    size_t replayed = 0;
+    uint64_t lastLsn = 0;
+    std::vector<JournalRecord> entry;
+
+    while(data.size() - pos >= ENTRY_HEADER_SIZE){
+        Reader header(data.data() + pos, ENTRY_HEADER_SIZE);
+        uint64_t bodyLength = 0, crc = 0;
+        header.little(4, bodyLength);
+        header.little(4, crc);
+        if(data.size() - pos - ENTRY_HEADER_SIZE < bodyLength){
+            break;
+        }
+
+        const char* body = data.data() + pos + ENTRY_HEADER_SIZE;
+        if(crc32(body, bodyLength) != crc){
+            break;
+        }
+
+        Reader in(body, bodyLength);
+        uint64_t lsn = 0, count = 0;
+        bool ok = in.little(8, lsn) && in.little(4, count);
+        entry.clear();
+        for(uint64_t i = 0; ok && i < count; ++i){
+            entry.emplace_back();
+            ok = decodeRecord(in, entry.back());
+        }
+        if(!ok || !in.done()){
+            break;
+        }
+
+        // the whole entry or nothing
+        for(const auto& rec : entry){
+            apply(rec);
+        }
+        replayed += entry.size();
+        lastLsn = lsn;
+        pos += ENTRY_HEADER_SIZE + bodyLength;
+    }
+
+    if(pos < data.size() && data.size() >= FILE_HEADER_SIZE){
+        std::cerr << "Journal: dropping " << data.size() - pos << " bytes of torn or corrupt tail\n";
+        if(ftruncate(fd, static_cast<off_t>(pos)) != 0){
+            std::cerr << "Journal: truncate failed: " << std::strerror(errno) << "\n";
+        }
+    }
+
+    fileBytes = pos;
+    nextLsn = std::max(nextLsn, lastLsn + 1);
+    appendedLsn = durableLsn = nextLsn - 1;
+    return replayed;
+}
+
+bool Journal::reset(){
+    std::unique_lock<std::mutex> lock(mtx);
+    synced.wait(lock, [this]{ return !syncing; });
+    if(fd < 0){
+        return !failed;
+    }
+
+    buffer.clear();
+    durableLsn = appendedLsn;
+
+    // swap in a fresh file rather than truncating, so a crash leaves either
+    // the old journal or the new empty one with its base
+    if(!createLocked(appendedLsn)){
+        return false;
+    }
+    ::close(fd);
+    fd = ::open(config.path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    if(fd == -1){
+        std::cerr << "Journal: cannot open " << config.path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    base = appendedLsn;
+    fileBytes = FILE_HEADER_SIZE;
+    failed = false; // everything up to the base is persisted elsewhere
+    return true;
+}
+
+bool Journal::hasFailed() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return failed;
+}
+
+uint64_t Journal::lastLsn() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return appendedLsn;
+}
+
+uint64_t Journal::baseLsn() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return base;
+}
+
+bool Journal::needsCheckpoint() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    // fileBytes includes the header; subtracting it keeps SIZE_MAX from wrapping
+    return fd >= 0 && (failed || fileBytes + buffer.size() - FILE_HEADER_SIZE >= config.checkpointBytes);
+}
+
+json Journal::stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return {
+        {"enabled", fd >= 0},
+        {"failed", failed},
+        {"policy", policyName(config.policy)},
+        {"entries", entries},
+        {"records", records},
+        {"bytes", fileBytes + buffer.size()},
+        {"syncs", syncs},
+        {"avgEntriesPerSync", syncs ? static_cast<double>(syncedEntries) / syncs : 0.0},
+        {"avgSyncMs", syncs ? totalSyncUs / 1000.0 / syncs : 0.0},
+        {"maxSyncMs", maxSyncUs / 1000.0}
+    };
+}
@@ -0,0 +1,73 @@
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other){
+    merge(other);
+}
+
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other){
+    if(this != &other){
+        reset();
+        merge(other);
+    }
+    return *this;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other){
+    for(size_t i = 0; i < BUCKETS; ++i){
+        uint64_t n = other.counts[i].load(std::memory_order_relaxed);
+        if(n != 0){
+            counts[i].store(counts[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+    total.store(total.load(std::memory_order_relaxed) + other.count(), std::memory_order_relaxed);
+    sum.store(sum.load(std::memory_order_relaxed) + other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    maxValue.store(std::max(max(), other.max()), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset(){
+    for(auto& n : counts){
+        n.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / n;
+}
+
+uint64_t LatencyHistogram::bucketTop(size_t bucket){
+    if(bucket < 2 * SUB_BUCKETS){
+        return bucket;
+    }
+    size_t shift = bucket / SUB_BUCKETS - 1;
+    uint64_t mantissa = bucket - shift * SUB_BUCKETS;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+    // counts and total are read separately, so walk against the bucket sum
+    // rather than total to stay consistent while a writer is recording
+    uint64_t seen = 0;
+    for(const auto& n : counts){
+        seen += n.load(std::memory_order_relaxed);
+    }
+    if(seen == 0){
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * seen));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t cumulative = 0;
+    for(size_t i = 0; i < BUCKETS; ++i){
+        cumulative += counts[i].load(std::memory_order_relaxed);
+        if(cumulative >= rank){
+            return std::min(bucketTop(i), max());
+        }
+    }
+    return max();
+}
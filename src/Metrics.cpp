@@ -0,0 +1,250 @@
+#include "Metrics.hpp"
+#include "Bank.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+    constexpr size_t REQUEST_KINDS = static_cast<size_t>(RequestKind::COUNT);
+    constexpr size_t REDIS_CALLS = static_cast<size_t>(RedisCall::COUNT);
+
+    const char* const REQUEST_NAMES[REQUEST_KINDS] = {
+        "CREATE", "DELETE", "MODIFY", "DEPOSIT", "WITHDRAW", "TRANSFER", "BATCH", "TRANSFER_BATCH",
+        "APPLY_INTEREST_ONE", "APPLY_INTEREST_ALL", "DISPLAY_ONE", "DISPLAY_ALL", "DELETE_ALL",
+        "EXPORT_JSON", "EXPORT_STATUS", "SNAPSHOT", "STATS", "HELLO", "EXIT", "INVALID"
+    };
+    const char* const REDIS_NAMES[REDIS_CALLS] = {
+        "save", "write_batch", "load", "load_batch", "delete", "delete_all", "scan"
+    };
+    const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+    // Histograms are allocated on first use, so a thread only pays for the
+    // actions it handles; readers may see a slot still null
+    LatencyHistogram& histogramIn(std::atomic<LatencyHistogram*>& slot){
+        LatencyHistogram* hist = slot.load(std::memory_order_relaxed);
+        if(hist == nullptr){
+            hist = new LatencyHistogram();
+            slot.store(hist, std::memory_order_release);
+        }
+        return *hist;
+    }
+
+    json summary(const LatencyHistogram& hist){
+        return {
+            {"count", hist.count()},
+            {"meanUs", hist.mean() / 1000.0},
+            {"p50Us", hist.percentile(50) / 1000.0},
+            {"p99Us", hist.percentile(99) / 1000.0},
+            {"p999Us", hist.percentile(99.9) / 1000.0},
+            {"maxUs", hist.max() / 1000.0}
+        };
+    }
+
+    void writeSummary(std::ostream& out, const char* metric, const char* label, const char* value, const LatencyHistogram& hist){
+        for(double q : QUANTILES){
+            out << metric << "{" << label << "=\"" << value << "\",quantile=\"" << q << "\"} "
+                << hist.percentile(q * 100) / 1e9 << "\n";
+        }
+        out << metric << "_sum{" << label << "=\"" << value << "\"} " << hist.mean() * hist.count() / 1e9 << "\n";
+        out << metric << "_count{" << label << "=\"" << value << "\"} " << hist.count() << "\n";
+    }
+}
+
+const char* requestKindName(RequestKind kind){
+    return REQUEST_NAMES[static_cast<size_t>(kind)];
+}
+
+RequestKind requestKindFromName(std::string_view action){
+    for(size_t i = 0; i < static_cast<size_t>(RequestKind::INVALID); ++i){
+        if(action == REQUEST_NAMES[i]){
+            return static_cast<RequestKind>(i);
+        }
+    }
+    return RequestKind::INVALID;
+}
+
+const char* redisCallName(RedisCall call){
+    return REDIS_NAMES[static_cast<size_t>(call)];
+}
+
+struct Metrics::ThreadMetrics{
+    std::array<std::atomic<LatencyHistogram*>, REQUEST_KINDS> requests{};
+    std::array<std::atomic<uint64_t>, REQUEST_KINDS> errors{};
+    std::array<std::atomic<LatencyHistogram*>, REDIS_CALLS> redis{};
+
+    ~ThreadMetrics(){
+        for(auto& hist : requests){
+            delete hist.load();
+        }
+        for(auto& hist : redis){
+            delete hist.load();
+        }
+    }
+};
+
+// Gives the thread's metrics back for reuse when the thread exits (a
+// connection thread in thread-per-connection mode), so their number is
+// bounded by the peak thread count rather than the connection count
+struct MetricsHandle{
+    Metrics::ThreadMetrics* metrics = nullptr;
+    ~MetricsHandle(){
+        if(metrics != nullptr){
+            Metrics::getInstance().release(metrics);
+        }
+    }
+};
+
+Metrics::Metrics() = default;
+Metrics::~Metrics() = default;
+
+Metrics::ThreadMetrics& Metrics::local(){
+    thread_local MetricsHandle handle;
+    if(handle.metrics == nullptr){
+        std::lock_guard<std::mutex> lock(mtx);
+        if(!idle.empty()){
+            handle.metrics = idle.back();
+            idle.pop_back();
+        }else{
+            all.push_back(std::make_unique<ThreadMetrics>());
+            handle.metrics = all.back().get();
+        }
+    }
+    return *handle.metrics;
+}
+
+void Metrics::release(ThreadMetrics* metrics){
+    std::lock_guard<std::mutex> lock(mtx);
+    idle.push_back(metrics);
+}
+
+void Metrics::recordRequest(RequestKind kind, bool ok, Clock::duration elapsed){
+    ThreadMetrics& metrics = local();
+    size_t i = static_cast<size_t>(kind);
+    histogramIn(metrics.requests[i]).record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    if(!ok){
+        metrics.errors[i].store(metrics.errors[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::recordRedis(RedisCall call, Clock::duration elapsed){
+    ThreadMetrics& metrics = local();
+    histogramIn(metrics.redis[static_cast<size_t>(call)]).record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Metrics::merge(std::array<LatencyHistogram, REQUEST_KINDS>& requests, std::array<uint64_t, REQUEST_KINDS>& errors,
+                    std::array<LatencyHistogram, REDIS_CALLS>& redis) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    for(const auto& metrics : all){
+        for(size_t i = 0; i < REQUEST_KINDS; ++i){
+            if(const LatencyHistogram* hist = metrics->requests[i].load(std::memory_order_acquire)){
+                requests[i].merge(*hist);
+            }
+            errors[i] += metrics->errors[i].load(std::memory_order_relaxed);
+        }
+        for(size_t i = 0; i < REDIS_CALLS; ++i){
+            if(const LatencyHistogram* hist = metrics->redis[i].load(std::memory_order_acquire)){
+                redis[i].merge(*hist);
+            }
+        }
+    }
+}
+
+json Metrics::stats() const {
+    // about 16 KB each, so keep them off the caller's stack
+    auto requests = std::make_unique<std::array<LatencyHistogram, REQUEST_KINDS>>();
+    auto redis = std::make_unique<std::array<LatencyHistogram, REDIS_CALLS>>();
+    std::array<uint64_t, REQUEST_KINDS> errors{};
+    merge(*requests, errors, *redis);
+
+    json result = {
+        {"requests", json::object()},
+        {"redis", json::object()},
+        {"connections", connections.load(std::memory_order_relaxed)},
+        {"accounts", Bank::getInstance().accountCount()}
+    };
+    for(size_t i = 0; i < REQUEST_KINDS; ++i){
+        if((*requests)[i].count() > 0){
+            json entry = summary((*requests)[i]);
+            entry["errors"] = errors[i];
+            result["requests"][REQUEST_NAMES[i]] = entry;
+        }
+    }
+    for(size_t i = 0; i < REDIS_CALLS; ++i){
+        if((*redis)[i].count() > 0){
+            result["redis"][REDIS_NAMES[i]] = summary((*redis)[i]);
+        }
+    }
+    return result;
+}
+
+std::string Metrics::prometheus() const {
+    auto requests = std::make_unique<std::array<LatencyHistogram, REQUEST_KINDS>>();
+    auto redis = std::make_unique<std::array<LatencyHistogram, REDIS_CALLS>>();
+    std::array<uint64_t, REQUEST_KINDS> errors{};
+    merge(*requests, errors, *redis);
+
+    std::ostringstream out;
+    out << std::setprecision(9);
+
+    out << "# HELP bank_requests_total Requests handled, by action.\n"
+        << "# TYPE bank_requests_total counter\n";
+    for(size_t i = 0; i < REQUEST_KINDS; ++i){
+        out << "bank_requests_total{action=\"" << REQUEST_NAMES[i] << "\"} " << (*requests)[i].count() << "\n";
+    }
+    out << "# HELP bank_request_errors_total Requests answered with a failed status, by action.\n"
+        << "# TYPE bank_request_errors_total counter\n";
+    for(size_t i = 0; i < REQUEST_KINDS; ++i){
+        out << "bank_request_errors_total{action=\"" << REQUEST_NAMES[i] << "\"} " << errors[i] << "\n";
+    }
+    out << "# HELP bank_request_duration_seconds Time to handle a request, by action.\n"
+        << "# TYPE bank_request_duration_seconds summary\n";
+    for(size_t i = 0; i < REQUEST_KINDS; ++i){
+        if((*requests)[i].count() > 0){
+            writeSummary(out, "bank_request_duration_seconds", "action", REQUEST_NAMES[i], (*requests)[i]);
+        }
+    }
+    out << "# HELP bank_redis_call_duration_seconds Time spent in RedisCache calls, by call.\n"
+        << "# TYPE bank_redis_call_duration_seconds summary\n";
+    for(size_t i = 0; i < REDIS_CALLS; ++i){
+        if((*redis)[i].count() > 0){
+            writeSummary(out, "bank_redis_call_duration_seconds", "call", REDIS_NAMES[i], (*redis)[i]);
+        }
+    }
+    out << "# HELP bank_connections Open client connections.\n"
+        << "# TYPE bank_connections gauge\n"
+        << "bank_connections " << connections.load(std::memory_order_relaxed) << "\n"
+        << "# HELP bank_accounts Accounts in memory.\n"
+        << "# TYPE bank_accounts gauge\n"
+        << "bank_accounts " << Bank::getInstance().accountCount() << "\n";
+    return out.str();
+}
+
+bool Metrics::writeFile(const std::string& path) const {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        file << prometheus();
+        if(!file){
+            return false;
+        }
+    }
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+void Metrics::startExporter(const std::string& path, std::chrono::seconds interval){
+    if(path.empty() || interval.count() <= 0){
+        return;
+    }
+
+    std::thread([this, path, interval](){
+        while(true){
+            if(!writeFile(path)){
+                std::cerr << "Cannot write metrics to " << path << ".\n";
+            }
+            std::this_thread::sleep_for(interval);
+        }
+    }).detach();
+}
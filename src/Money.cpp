@@ -0,0 +1,136 @@
+#include "Money.hpp"
+#include <charconv>
+#include <algorithm>
+#include <limits>
+
+namespace {
+    constexpr std::int64_t POW10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+}
+
+bool money::parseFixed(std::string_view text, int digits, std::int64_t& out, bool roundExcess){
+    const char* p = text.data();
+    const char* end = p + text.size();
+    bool negative = false;
+
+    if(p != end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        ++p;
+    }
+
+    // accumulate as a negative number so INT64_MIN-scale values are reachable
+    constexpr std::int64_t LIMIT = std::numeric_limits<std::int64_t>::min();
+    std::int64_t value = 0;
+    bool anyDigit = false;
+
+    for(; p != end && *p >= '0' && *p <= '9'; ++p){
+        int d = *p - '0';
+        if(value < (LIMIT + d) / 10){
+            return false;
+        }
+        value = value * 10 - d;
+        anyDigit = true;
+    }
+
+    int fraction = 0;
+    bool roundUp = false;
+    if(p != end && *p == '.'){
+        for(++p; p != end && *p >= '0' && *p <= '9'; ++p){
+            anyDigit = true;
+            if(fraction < digits){
+                int d = *p - '0';
+                if(value < (LIMIT + d) / 10){
+                    return false;
+                }
+                value = value * 10 - d;
+                ++fraction;
+            }else if(!roundExcess){
+                return false;
+            }else if(fraction == digits){
+                roundUp = *p >= '5';
+                ++fraction; // only the first excess digit decides
+            }
+        }
+    }
+
+    if(!anyDigit || p != end){
+        return false;
+    }
+
+    for(int i = std::min(fraction, digits); i < digits; ++i){
+        if(value < LIMIT / 10){
+            return false;
+        }
+        value *= 10;
+    }
+
+    if(roundUp){
+        if(value == LIMIT){
+            return false;
+        }
+        --value;
+    }
+
+    if(!negative){
+        if(value == LIMIT){
+            return false;
+        }
+        value = -value;
+    }
+
+    out = value;
+    return true;
+}
+
+char* money::formatFixed(std::int64_t value, int digits, char* out, bool trimZeros){
+    // work in unsigned so INT64_MIN formats correctly
+    std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    std::uint64_t scale = static_cast<std::uint64_t>(POW10[digits]);
+    std::uint64_t whole = magnitude / scale;
+    std::uint64_t fraction = magnitude % scale;
+
+    if(value < 0){
+        *out++ = '-';
+    }
+    out = std::to_chars(out, out + 20, whole).ptr;
+
+    if(digits == 0){
+        return out;
+    }
+
+    *out++ = '.';
+    for(int i = digits - 1; i >= 0; --i){
+        out[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    out += digits;
+
+    if(trimZeros){
+        while(out[-1] == '0'){
+            --out;
+        }
+        if(out[-1] == '.'){
+            --out;
+        }
+    }
+    return out;
+}
+
+bool money::parse(std::string_view text, Money& out){
+    return parseFixed(text, CENT_DIGITS, out);
+}
+
+bool money::parseRate(std::string_view text, Rate& out){
+    return parseFixed(text, RATE_DIGITS, out);
+}
+
+std::string money::toString(Money amount){
+    char buf[MAX_CHARS];
+    return std::string(buf, formatFixed(amount, CENT_DIGITS, buf));
+}
+
+std::string money::rateToString(Rate rate){
+    char buf[MAX_CHARS];
+    return std::string(buf, formatFixed(rate, RATE_DIGITS, buf, true));
+}
@@ -1,11 +1,129 @@
 #include "../include/Network.hpp"
+#include <cerrno>
+
+namespace {
+    bool recvAll(int socketFD, char* data, size_t size){
+        size_t done = 0;
+        while(done < size){
+            ssize_t n = recv(socketFD, data + done, size - done, 0);
+            if(n > 0){
+                done += n;
+            }else if(n == -1 && errno == EINTR){
+                continue;
+            }else{
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t decodeLength(const char* header){
+        const auto* b = reinterpret_cast<const unsigned char*>(header);
+        return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+    }
+}
+
+void appendFrame(std::string& out, std::string_view payload){
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    char header[FRAME_HEADER_SIZE] = {
+        static_cast<char>(length >> 24), static_cast<char>(length >> 16),
+        static_cast<char>(length >> 8), static_cast<char>(length)
+    };
+    out.append(header, FRAME_HEADER_SIZE);
+    out.append(payload.data(), payload.size());
+}
+
+size_t beginFrame(std::string& out){
+    size_t start = out.size();
+    out.append(FRAME_HEADER_SIZE, '\0');
+    return start;
+}
+
+void endFrame(std::string& out, size_t start){
+    uint32_t length = static_cast<uint32_t>(out.size() - start - FRAME_HEADER_SIZE);
+    out[start] = static_cast<char>(length >> 24);
+    out[start + 1] = static_cast<char>(length >> 16);
+    out[start + 2] = static_cast<char>(length >> 8);
+    out[start + 3] = static_cast<char>(length);
+}
+
+bool sendAll(int socketFD, const char* data, size_t size){
+    size_t done = 0;
+    while(done < size){
+        ssize_t n = send(socketFD, data + done, size - done, MSG_NOSIGNAL);
+        if(n > 0){
+            done += n;
+        }else if(n == -1 && errno == EINTR){
+            continue;
+        }else{
+            return false;
+        }
+    }
+    return true;
+}
 
 bool sendMessage(int socketFD, const std::string& message){
-    return send(socketFD, message.c_str(), message.size(), 0) >= 0;
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + message.size());
+    appendFrame(frame, message);
+    return sendAll(socketFD, frame.data(), frame.size());
 }
 
 std::string recieveMessage(int socketFD){
-    char buffer[BUFFER_SIZE] = {0};
-    int bytesRead = read(socketFD, buffer, BUFFER_SIZE);
-    return bytesRead > 0 ? std::string(buffer, bytesRead) : "";
-}
\ No newline at end of file
+    char header[FRAME_HEADER_SIZE];
+    if(!recvAll(socketFD, header, FRAME_HEADER_SIZE)){
+        return "";
+    }
+
+    uint32_t length = decodeLength(header);
+    if(length > MAX_FRAME_SIZE){
+        return "";
+    }
+
+    std::string payload(length, '\0');
+    return recvAll(socketFD, payload.data(), length) ? payload : "";
+}
+
+ssize_t FrameReader::readFrom(int socketFD){
+    char chunk[BUFFER_SIZE];
+    ssize_t n = recv(socketFD, chunk, BUFFER_SIZE, 0);
+    if(n > 0){
+        append(chunk, n);
+    }
+    return n;
+}
+
+void FrameReader::append(const char* data, size_t size){
+    compact();
+    buffer.append(data, size);
+}
+
+bool FrameReader::nextFrame(std::string_view& payload){
+    if(buffer.size() - readPos < FRAME_HEADER_SIZE){
+        return false;
+    }
+
+    uint32_t length = decodeLength(buffer.data() + readPos);
+    if(length > MAX_FRAME_SIZE){
+        tooLarge = true;
+        return false;
+    }
+    if(buffer.size() - readPos - FRAME_HEADER_SIZE < length){
+        return false;
+    }
+
+    payload = std::string_view(buffer.data() + readPos + FRAME_HEADER_SIZE, length);
+    readPos += FRAME_HEADER_SIZE + length;
+    return true;
+}
+
+bool FrameReader::oversized() const {
+    return tooLarge;
+}
+
+void FrameReader::compact(){
+    if(readPos > 0){
+        buffer.erase(0, readPos);
+        readPos = 0;
+    }
+}
@@ -1,68 +1,327 @@
 #include "RedisCache.hpp"
+#include "Metrics.hpp"
+#include <algorithm>
+#include <charconv>
 
 using namespace sw::redis;
 
-RedisCache::RedisCache() : redis("tcp://127.0.0.1:6379") {}
+RedisConfig& RedisCache::settings(){
+    static RedisConfig config;
+    return config;
+}
 
-void RedisCache::saveAccount(const Account& acc){
-    std::string key = "account:" + std::to_string(acc.getAccountNumber());
+void RedisCache::configure(const RedisConfig& config){
+    settings() = config;
+}
+
+namespace {
+    ConnectionOptions connectionOptions(const RedisConfig& config){
+        ConnectionOptions options;
+        options.host = config.host;
+        options.port = config.port;
+        options.connect_timeout = config.connectTimeout;
+        options.socket_timeout = config.socketTimeout;
+        options.keep_alive = config.keepAlive;
+        return options;
+    }
+
+    ConnectionPoolOptions poolOptions(const RedisConfig& config){
+        ConnectionPoolOptions options;
+        options.size = std::max<size_t>(1, config.poolSize);
+        options.wait_timeout = config.poolWaitTimeout;
+        return options;
+    }
+}
+
+RedisCache::RedisCache(const RedisConfig& config) : redis(connectionOptions(config), poolOptions(config)) {
+    // one connection is left to request threads (loads, scans) whenever the
+    // pool has more than one
+    size_t threads = std::max<size_t>(1, std::max<size_t>(1, config.poolSize) - 1);
+    for(size_t i = 0; i < threads; ++i){
+        ioThreads.emplace_back(&RedisCache::runIo, this);
+    }
+}
+
+RedisCache::~RedisCache(){
+    {
+        std::lock_guard<std::mutex> lock(ioMtx);
+        ioStopping = true;
+    }
+    ioReady.notify_all();
+    for(auto& thread : ioThreads){
+        thread.join(); // queued tasks run first
+    }
+}
+
+void RedisCache::runIo(){
+    std::unique_lock<std::mutex> lock(ioMtx);
+    while(true){
+        ioReady.wait(lock, [this]{ return ioStopping || !ioTasks.empty(); });
+        if(ioTasks.empty()){
+            return;
+        }
+        std::packaged_task<void()> task = std::move(ioTasks.front());
+        ioTasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+std::future<bool> RedisCache::writeBatchAsync(std::vector<int> deletes, std::vector<std::shared_ptr<Account>> saves){
+    auto result = std::make_shared<std::promise<bool>>();
+    std::future<bool> done = result->get_future();
+    std::packaged_task<void()> task([this, result, deletes = std::move(deletes), saves = std::move(saves)](){
+        result->set_value(writeBatch(deletes, saves));
+    });
+    {
+        std::lock_guard<std::mutex> lock(ioMtx);
+        ioTasks.push_back(std::move(task));
+    }
+    ioReady.notify_one();
+    return done;
+}
+
+// version is what the fields reflect, for Account::markSaved once written
+static std::unordered_map<std::string, std::string> accountFields(const Account& acc, uint64_t& version){
+    // one consistent copy under one lock, instead of a lock per getter
+    AccountImage image;
+    {
+        std::unique_lock<std::mutex> lock = acc.lock();
+        image = acc.imageLocked();
+        version = acc.versionLocked();
+    }
 
     std::unordered_map<std::string, std::string> fields = {
-        {"type", acc.getAccountType()},
-        {"name", acc.getHolderName()},
-        {"balance", std::to_string(acc.getBalance())}
+        {"type", accountTypeName(image.type)},
+        {"name", std::move(image.holderName)},
+        {"balance", money::toString(image.balance)}
     };
 
-    if(acc.getAccountType() == "SAVINGS"){
-        const auto* savings = dynamic_cast<const SavingsAccount*>(&acc);
-        fields["interest"] = std::to_string(savings->getInterestRate());
-    }else if(acc.getAccountType() == "CHECKING"){
-        const auto* checking = dynamic_cast<const CheckingAccount*>(&acc);
-        fields["overdraft"] = std::to_string(checking->getOverDraftLimit());
+    if(image.type == AccountType::SAVINGS){
+        fields["interest"] = money::rateToString(image.rateOrLimit);
+    }else{
+        fields["overdraft"] = std::to_string(image.rateOrLimit);
     }
+    return fields;
+}
+
+void RedisCache::saveAccount(const Account& acc){
+    RedisTimer timer(RedisCall::SAVE);
+    std::string key = "account:" + std::to_string(acc.getAccountNumber());
+    uint64_t version;
+    std::unordered_map<std::string, std::string> fields = accountFields(acc, version);
     
     try{
         redis.hset(key, fields.begin(), fields.end());
         redis.sadd("accounts", std::to_string(acc.getAccountNumber()));
+        acc.markSaved(version);
     }catch(const sw::redis::Error &err){
         std::cerr << "Redis Error: " << err.what() << std::endl;
     }
 }
 
+bool RedisCache::writeBatch(const std::vector<int>& deletes, const std::vector<std::shared_ptr<Account>>& saves){
+    if(deletes.empty() && saves.empty()){
+        return true;
+    }
+
+    RedisTimer timer(RedisCall::WRITE_BATCH);
+    try{
+        // one round trip for the whole batch instead of two per account
+        auto pipe = redis.pipeline(false);
+        for(int accNum : deletes){
+            pipe.del("account:" + std::to_string(accNum));
+            pipe.srem("accounts", std::to_string(accNum));
+        }
+        std::vector<uint64_t> versions(saves.size());
+        for(size_t i = 0; i < saves.size(); ++i){
+            std::string accNum = std::to_string(saves[i]->getAccountNumber());
+            std::unordered_map<std::string, std::string> fields = accountFields(*saves[i], versions[i]);
+            pipe.hset("account:" + accNum, fields.begin(), fields.end());
+            pipe.sadd("accounts", accNum);
+        }
+        pipe.exec();
+        // a failed batch throws before this, leaving its accounts dirty
+        for(size_t i = 0; i < saves.size(); ++i){
+            saves[i]->markSaved(versions[i]);
+        }
+    }catch(const sw::redis::Error &err){
+        std::cerr << "Redis Error: " << err.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+namespace {
+    using FieldList = std::vector<std::pair<std::string, std::string>>;
+
+    template <typename T>
+    bool parseNumber(const std::string& text, T& out){
+        const char* end = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(text.data(), end, out);
+        return ec == std::errc() && ptr == end;
+    }
+
+    // Fields written before balances were fixed point carry std::to_string's
+    // six decimals, so excess digits are rounded rather than rejected
+    bool parseFixedField(const std::string& text, int digits, int64_t& out){
+        return money::parseFixed(text, digits, out, true);
+    }
+
+    // Builds an account from its HGETALL fields; nullptr if malformed
+    std::unique_ptr<Account> parseAccount(int accNum, const FieldList& accountData){
+        const std::string* name = nullptr;
+        const std::string* type = nullptr;
+        const std::string* balanceText = nullptr;
+        const std::string* extra = nullptr;
+
+        for(const auto& [field, value] : accountData){
+            if(field == "name") name = &value;
+            else if(field == "type") type = &value;
+            else if(field == "balance") balanceText = &value;
+            else if(field == "interest" || field == "overdraft") extra = &value;
+        }
+
+        Money balance;
+        if(!name || !type || !balanceText || !extra || !parseFixedField(*balanceText, money::CENT_DIGITS, balance)){
+            std::cerr << "Malformed account #" << accNum << ".\n";
+            return nullptr;
+        }
+
+        AccountType accountType;
+        if(!parseAccountType(*type, accountType)){
+            std::cerr << "Unkown account type.\n";
+            return nullptr;
+        }
+
+        if(accountType == AccountType::SAVINGS){
+            Rate interestRate;
+            if(parseFixedField(*extra, money::RATE_DIGITS, interestRate)){
+                return std::make_unique<SavingsAccount>(accNum, *name, balance, interestRate);
+            }
+        }else{
+            int overDraftLimit;
+            if(parseNumber(*extra, overDraftLimit)){
+                return std::make_unique<CheckingAccount>(accNum, *name, balance, overDraftLimit);
+            }
+        }
+
+        std::cerr << "Malformed account #" << accNum << ".\n";
+        return nullptr;
+    }
+}
+
 std::unique_ptr<Account> RedisCache::loadAccount(int accNum){
+    RedisTimer timer(RedisCall::LOAD);
     std::string key = "account:" + std::to_string(accNum);
 
-    if(!redis.exists(key)){
+    FieldList accountData;
+    redis.hgetall(key, std::back_inserter(accountData));
+
+    // HGETALL of a missing key is empty, so no separate EXISTS round trip
+    if(accountData.empty()){
         std::cerr << "Account number #" << accNum << " does not exist.\n";
         return nullptr;
     }
-    
-    std::unordered_map<std::string, std::string> accountData;
-    redis.hgetall(key, std::inserter(accountData, accountData.begin()));
-
-    std::string name = accountData["name"];
-    double balance = std::stod(accountData["balance"]);
-    std::string type = accountData["type"];
-
-    if(type == "SAVINGS"){
-        double interestRate = std::stod(accountData["interest"]);
-        return std::make_unique<SavingsAccount>(accNum, name, balance, interestRate);
-    }else if(type == "CHECKING"){
-        int overDraftLimit = std::stoi(accountData["overdraft"]);
-        return std::make_unique<CheckingAccount>(accNum, name, balance, overDraftLimit);
-    }else{
-        std::cerr << "Unkown account type.\n";
-        return nullptr;
+
+    return parseAccount(accNum, accountData);
+}
+
+sw::redis::Pipeline RedisCache::newPipeline(){
+    return redis.pipeline(true);
+}
+
+void RedisCache::loadAccounts(sw::redis::Pipeline& pipe, const std::vector<int>& accNums, std::vector<std::unique_ptr<Account>>& out){
+    RedisTimer timer(RedisCall::LOAD_BATCH);
+    for(int accNum : accNums){
+        pipe.hgetall("account:" + std::to_string(accNum));
+    }
+
+    auto replies = pipe.exec();
+    for(size_t i = 0; i < accNums.size(); ++i){
+        FieldList accountData;
+        replies.get(i, std::back_inserter(accountData));
+        if(accountData.empty()){
+            continue; // deleted since the SCAN
+        }
+
+        std::unique_ptr<Account> acc = parseAccount(accNums[i], accountData);
+        if(acc){
+            out.push_back(std::move(acc));
+        }
     }
 }
 
 void RedisCache::deleteAccount(int accNum){
+    RedisTimer timer(RedisCall::DELETE);
     std::string key = "account:" + std::to_string(accNum);
     redis.del(key);
     redis.srem("accounts", std::to_string(accNum));
 }
 
+size_t RedisCache::deleteAllAccounts(){
+    constexpr long long UNLINK_BATCH = 1000; // SSCAN COUNT hint, so about this many keys per UNLINK
+    RedisTimer timer(RedisCall::DELETE_ALL);
+
+    // the "accounts" set lists every account key, so walk it rather than
+    // the whole keyspace; nothing writes to it while the wipe runs
+    auto pipe = redis.pipeline(false);
+    std::vector<std::string> members;
+    std::vector<std::string> keys;
+    size_t unlinks = 0;
+    sw::redis::Cursor cursor = 0;
+    do{
+        members.clear();
+        cursor = redis.sscan("accounts", cursor, UNLINK_BATCH, std::back_inserter(members));
+        if(members.empty()){
+            continue;
+        }
+        keys.clear();
+        for(const auto& accNum : members){
+            keys.push_back("account:" + accNum);
+        }
+        pipe.unlink(keys.begin(), keys.end());
+        ++unlinks;
+    }while(cursor != 0);
+
+    pipe.unlink("accounts");
+    auto replies = pipe.exec();
+
+    // SSCAN may return a member more than once, so count what each UNLINK
+    // actually removed rather than the keys it was given
+    size_t removed = 0;
+    for(size_t i = 0; i < unlinks; ++i){
+        removed += static_cast<size_t>(replies.get<long long>(i));
+    }
+    return removed;
+}
+
+std::vector<int> RedisCache::getAllAccountNumbers(long long scanCount){
+    RedisTimer timer(RedisCall::SCAN);
+    std::vector<std::string> keys;
+    std::vector<int> accNums;
+    sw::redis::Cursor cursor = 0;
+
+    do{
+        keys.clear();
+        cursor = redis.scan(cursor, "account:*", scanCount, std::back_inserter(keys));
+        for(const auto& key : keys){
+            int accNum;
+            const char* begin = key.data() + key.find(':') + 1;
+            const char* end = key.data() + key.size();
+            auto [ptr, ec] = std::from_chars(begin, end, accNum);
+            if(ec == std::errc() && ptr == end){
+                accNums.push_back(accNum);
+            }
+        }
+    }while(cursor != 0);
+
+    return accNums;
+}
+
 std::vector<std::string> RedisCache::getAllAccountKeys(){
+    RedisTimer timer(RedisCall::SCAN);
     std::vector<std::string> keys;
     sw::redis::Cursor cursor = 0;
 
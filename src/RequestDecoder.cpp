@@ -0,0 +1,310 @@
+#include "RequestDecoder.hpp"
+#include <charconv>
+#include <limits>
+
+namespace {
+    bool isDigit(char c){
+        return c >= '0' && c <= '9';
+    }
+}
+
+bool RequestDecoder::parse(std::string_view payload){
+    text = payload;
+    pos = 0;
+    count = 0;
+
+    skipSpace();
+    if(pos >= text.size() || text[pos] != '{'){
+        return false;
+    }
+    ++pos;
+    skipSpace();
+    if(pos < text.size() && text[pos] == '}'){
+        ++pos;
+    }else{
+        while(true){
+            Field field;
+            if(!parseString(field.key)){
+                return false;
+            }
+            skipSpace();
+            if(pos >= text.size() || text[pos] != ':'){
+                return false;
+            }
+            ++pos;
+            if(!parseValue(field.kind, field.value, 1)){
+                return false;
+            }
+
+            // json::parse keeps the last of repeated keys, so do we
+            Field* slot = nullptr;
+            for(size_t i = 0; i < count; ++i){
+                if(fields[i].key == field.key){
+                    slot = &fields[i];
+                    break;
+                }
+            }
+            if(slot == nullptr){
+                if(count == MAX_FIELDS){
+                    return false;
+                }
+                slot = &fields[count++];
+            }
+            *slot = field;
+
+            skipSpace();
+            if(pos < text.size() && text[pos] == ','){
+                ++pos;
+                skipSpace();
+                continue;
+            }
+            if(pos < text.size() && text[pos] == '}'){
+                ++pos;
+                break;
+            }
+            return false;
+        }
+    }
+
+    skipSpace();
+    return pos == text.size();
+}
+
+const RequestDecoder::Field* RequestDecoder::find(std::string_view key) const {
+    for(size_t i = 0; i < count; ++i){
+        if(fields[i].key == key){
+            return &fields[i];
+        }
+    }
+    return nullptr;
+}
+
+void RequestDecoder::skipSpace(){
+    while(pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')){
+        ++pos;
+    }
+}
+
+bool RequestDecoder::parseValue(Kind& kind, std::string_view& value, int depth){
+    skipSpace();
+    if(pos >= text.size()){
+        return false;
+    }
+
+    size_t start = pos;
+    bool ok;
+    switch(text[pos]){
+        case '"':
+            kind = Kind::STRING;
+            return parseString(value);
+        case '{':
+            kind = Kind::OBJECT;
+            ok = parseContainer('}', depth);
+            break;
+        case '[':
+            kind = Kind::ARRAY;
+            ok = parseContainer(']', depth);
+            break;
+        case 't':
+            kind = Kind::LITERAL;
+            ok = parseLiteral("true");
+            break;
+        case 'f':
+            kind = Kind::LITERAL;
+            ok = parseLiteral("false");
+            break;
+        case 'n':
+            kind = Kind::LITERAL;
+            ok = parseLiteral("null");
+            break;
+        default:
+            kind = Kind::NUMBER;
+            ok = parseNumber();
+            break;
+    }
+    value = text.substr(start, pos - start);
+    return ok;
+}
+
+bool RequestDecoder::parseString(std::string_view& value){
+    if(pos >= text.size() || text[pos] != '"'){
+        return false;
+    }
+    size_t start = ++pos;
+    while(pos < text.size()){
+        unsigned char c = static_cast<unsigned char>(text[pos]);
+        if(c == '"'){
+            value = text.substr(start, pos - start);
+            ++pos;
+            return true;
+        }
+        // escapes and non-ASCII need unescaping / UTF-8 validation: decline
+        if(c == '\\' || c < 0x20 || c >= 0x80){
+            return false;
+        }
+        ++pos;
+    }
+    return false;
+}
+
+bool RequestDecoder::parseNumber(){
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    if(pos < text.size() && text[pos] == '-'){
+        ++pos;
+    }
+    if(pos >= text.size() || !isDigit(text[pos])){
+        return false;
+    }
+    if(text[pos] == '0'){
+        ++pos;
+    }else{
+        while(pos < text.size() && isDigit(text[pos])){
+            ++pos;
+        }
+    }
+    if(pos < text.size() && text[pos] == '.'){
+        ++pos;
+        if(pos >= text.size() || !isDigit(text[pos])){
+            return false;
+        }
+        while(pos < text.size() && isDigit(text[pos])){
+            ++pos;
+        }
+    }
+    if(pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')){
+        ++pos;
+        if(pos < text.size() && (text[pos] == '+' || text[pos] == '-')){
+            ++pos;
+        }
+        if(pos >= text.size() || !isDigit(text[pos])){
+            return false;
+        }
+        while(pos < text.size() && isDigit(text[pos])){
+            ++pos;
+        }
+    }
+    return true;
+}
+
+bool RequestDecoder::parseLiteral(std::string_view word){
+    if(text.compare(pos, word.size(), word) != 0){
+        return false;
+    }
+    pos += word.size();
+    return true;
+}
+
+bool RequestDecoder::parseContainer(char close, int depth){
+    if(depth >= MAX_DEPTH){
+        return false;
+    }
+    ++pos;
+    skipSpace();
+    if(pos < text.size() && text[pos] == close){
+        ++pos;
+        return true;
+    }
+
+    while(true){
+        if(close == '}'){
+            std::string_view key;
+            if(!parseString(key)){
+                return false;
+            }
+            skipSpace();
+            if(pos >= text.size() || text[pos] != ':'){
+                return false;
+            }
+            ++pos;
+        }
+
+        Kind kind;
+        std::string_view value;
+        if(!parseValue(kind, value, depth + 1)){
+            return false;
+        }
+
+        skipSpace();
+        if(pos < text.size() && text[pos] == ','){
+            ++pos;
+            skipSpace();
+            continue;
+        }
+        if(pos < text.size() && text[pos] == close){
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+}
+
+namespace fields{
+    Error parseInt(std::string_view text, int& out){
+        if(text.empty() || text.find_first_not_of("-0123456789") != std::string_view::npos){
+            return Error::INT_CHARACTERS;
+        }
+
+        long num = 0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), num);
+        if(ec == std::errc::invalid_argument){
+            return Error::INT_FORMAT;
+        }
+        if(ec == std::errc::result_out_of_range){
+            return Error::INT_RANGE;
+        }
+        if(end != text.data() + text.size()){
+            return Error::INT_TRAILING;
+        }
+        if(num < std::numeric_limits<int>::min() || num > std::numeric_limits<int>::max()){
+            return Error::INT_RANGE;
+        }
+
+        out = static_cast<int>(num);
+        return Error::OK;
+    }
+
+    Error parseAmount(std::string_view text, Money& out){
+        if(!money::parse(text, out)){
+            return Error::AMOUNT_FORMAT;
+        }
+        return amountInRange(out) ? Error::OK : Error::AMOUNT_RANGE;
+    }
+
+    Error parseRate(std::string_view text, Rate& out){
+        if(!money::parseRate(text, out)){
+            return Error::RATE_FORMAT;
+        }
+        return rateInRange(out) ? Error::OK : Error::RATE_RANGE;
+    }
+
+    std::string message(Error error, std::string_view key){
+        std::string quoted = "'" + std::string(key) + "'";
+        switch(error){
+            case Error::OK:
+                return "";
+            case Error::MISSING:
+                return "Missing field " + quoted;
+            case Error::NOT_A_STRING:
+                return "Invalid request format";
+            case Error::INT_CHARACTERS:
+                return "Invalid integer format for " + quoted + ". Must contain only digits.";
+            case Error::INT_FORMAT:
+                return "Invalid integer format for " + quoted;
+            case Error::INT_TRAILING:
+                return "Invalid integer format for " + quoted + ". Trailing characters detected.";
+            case Error::INT_RANGE:
+                return "Integer value for " + quoted + " is out of range.";
+            case Error::AMOUNT_FORMAT:
+                return "Invalid amount format for " + quoted + ". Expected a number with at most " +
+                       std::to_string(money::CENT_DIGITS) + " decimal places.";
+            case Error::AMOUNT_RANGE:
+                return "Amount for " + quoted + " is out of range (at most " + money::toString(money::MAX_AMOUNT) + ").";
+            case Error::RATE_FORMAT:
+                return "Invalid rate format for " + quoted + ". Expected a number with at most " +
+                       std::to_string(money::RATE_DIGITS) + " decimal places.";
+            case Error::RATE_RANGE:
+                return "Rate for " + quoted + " is out of range (at most " + money::rateToString(money::MAX_RATE) + ").";
+        }
+        return "";
+    }
+}
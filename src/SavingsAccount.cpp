@@ -1,12 +1,12 @@
 #include "SavingsAccount.hpp"
 
-json SavingsAccount::withdraw(double amount) {
+json SavingsAccount::withdraw(Money amount) {
     std::lock_guard<std::mutex> lock(mtx);
     std::stringstream ss;
     json msg;
-    if(balance - amount >= 0){
+    if(canWithdrawLocked(amount)){
         balance -= amount;
-        ss << "New balance of $" << balance;
+        ss << "New balance of $" << money::toString(balance);
         msg = {
             {"status", "success: "},
             {"message", ss.str()}
@@ -15,7 +15,7 @@ json SavingsAccount::withdraw(double amount) {
     }else{
         ss << "Insufficient funds in savings account.";
         msg = {
-            {"status", "success: "},
+            {"status", "failed: "},
             {"message", ss.str()}
         };
         return msg;
@@ -23,9 +23,10 @@ json SavingsAccount::withdraw(double amount) {
 }
 
 json SavingsAccount::display() const {
+    std::lock_guard<std::mutex> lock(mtx);
     std::stringstream ss;
     json msg;
-    ss << "SAVINGS " << accountNumber << " " << holderName << " " << balance << " " << interestRate;
+    ss << "SAVINGS " << accountNumber << " " << holderName << " " << money::toString(balance) << " " << money::rateToString(interestRate);
     msg = {
         {"status", "success: "},
         {"message", ss.str()}
@@ -37,9 +38,15 @@ json SavingsAccount::applyInterest() {
     std::lock_guard<std::mutex> lock(mtx);
     std::stringstream ss;
     json msg;
-    double interest = balance * interestRate;
-    balance += interest;
-    ss << "New balance of $" << balance;
+    Money interest;
+    if(!money::interestOn(balance, interestRate, interest) || !money::add(balance, interest, balance)){
+        msg = {
+            {"status", "failed: "},
+            {"message", "Balance would overflow."}
+        };
+        return msg;
+    }
+    ss << "New balance of $" << money::toString(balance);
     msg = {
         {"status", "success: "},
         {"message", ss.str()}
@@ -47,29 +54,23 @@ json SavingsAccount::applyInterest() {
     return msg;
 }
 
-void SavingsAccount::setInterestRate(double newRate) {
+void SavingsAccount::setInterestRate(Rate newRate) {
     std::lock_guard<std::mutex> lock(mtx);
     interestRate = newRate;
 }
 
-std::string SavingsAccount::getHolderName() const {
-    return holderName;
-}
-
-std::string SavingsAccount::getAccountType() const {
-    return "SAVINGS";
-}
-
-double SavingsAccount::getInterestRate() const {
+Rate SavingsAccount::getInterestRate() const {
+    std::lock_guard<std::mutex> lock(mtx);
     return interestRate;
 }
 
 json SavingsAccount::toJson() const {
+    std::lock_guard<std::mutex> lock(mtx);
     return {
         {"accountType", "SAVINGS"},
         {"accountNumber", accountNumber},
         {"holderName", holderName},
-        {"balance", balance},
-        {"interestRate", interestRate}
+        {"balance", money::toString(balance)},
+        {"interestRate", money::rateToString(interestRate)}
     };
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "Snapshot.hpp"
+#include "Crc32.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the snapshot is mapped in place as little-endian");
+static_assert(sizeof(Snapshot::Record) == 32, "snapshot record layout");
+static_assert(sizeof(Snapshot::Header) == 48, "snapshot header layout");
+
+namespace {
+    constexpr char MAGIC[8] = {'B', 'A', 'N', 'K', 'S', 'N', 'A', 'P'};
+
+    bool writeAll(int fd, const void* data, size_t size){
+        const char* p = static_cast<const char*>(data);
+        while(size > 0){
+            ssize_t n = ::write(fd, p, size);
+            if(n == -1){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+
+long long Snapshot::write(const std::string& path, const AccountRegistry& registry, uint64_t journalLsn){
+    std::vector<Record> recs;
+    std::string namePool;
+    recs.reserve(registry.size());
+
+    for(size_t shard = 0; shard < AccountRegistry::SHARD_COUNT; ++shard){
+        for(const auto& acc : registry.shardSnapshot(shard)){
+            AccountImage image;
+            {
+                std::unique_lock<std::mutex> lock = acc->lock();
+                if(acc->isClosed()){
+                    continue;
+                }
+                image = acc->imageLocked();
+            }
+
+            Record rec{};
+            rec.accountNumber = image.accountNumber;
+            rec.type = static_cast<uint8_t>(image.type);
+            rec.balance = image.balance;
+            rec.rateOrLimit = image.rateOrLimit;
+            rec.nameOffset = static_cast<uint32_t>(namePool.size());
+            rec.nameLength = static_cast<uint32_t>(image.holderName.size());
+            namePool += image.holderName;
+            recs.push_back(rec);
+        }
+    }
+
+    std::sort(recs.begin(), recs.end(), [](const Record& a, const Record& b){
+        return a.accountNumber < b.accountNumber;
+    });
+
+    Header head{};
+    std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+    head.version = VERSION;
+    head.recordSize = sizeof(Record);
+    head.count = recs.size();
+    head.journalLsn = journalLsn;
+    head.namesBytes = namePool.size();
+    head.bodyCrc = crc32(namePool.data(), namePool.size(), crc32(recs.data(), recs.size() * sizeof(Record)));
+    head.headerCrc = crc32(&head, offsetof(Header, headerCrc));
+
+    // write aside and rename, so readers only ever see a complete image
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 &&
+              writeAll(fd, &head, sizeof(head)) &&
+              writeAll(fd, recs.data(), recs.size() * sizeof(Record)) &&
+              writeAll(fd, namePool.data(), namePool.size()) &&
+              fsync(fd) == 0;
+    if(fd >= 0){
+        ::close(fd);
+    }
+    if(!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0){
+        std::cerr << "Snapshot: cannot write " << path << ": " << std::strerror(errno) << "\n";
+        std::remove(tmpPath.c_str());
+        return -1;
+    }
+    return static_cast<long long>(recs.size());
+}
+
+Snapshot::~Snapshot(){
+    if(map){
+        munmap(map, mapSize);
+    }
+}
+
+bool Snapshot::open(const std::string& path){
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1){
+        return false; // no snapshot yet
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)){
+        ::close(fd);
+        std::cerr << "Snapshot: " << path << " is truncated\n";
+        return false;
+    }
+
+    mapSize = static_cast<size_t>(st.st_size);
+    map = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if(map == MAP_FAILED){
+        map = nullptr;
+        std::cerr << "Snapshot: cannot map " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    madvise(map, mapSize, MADV_SEQUENTIAL);
+
+    header = static_cast<const Header*>(map);
+    const char* base = static_cast<const char*>(map);
+    bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                 header->headerCrc == crc32(header, offsetof(Header, headerCrc));
+    if(!valid || header->version != VERSION || header->recordSize != sizeof(Record)){
+        std::cerr << "Snapshot: " << path << " has an unknown or corrupt header\n";
+        return false;
+    }
+
+    size_t bodySize = mapSize - sizeof(Header);
+    if(header->count > bodySize / sizeof(Record) ||
+       header->namesBytes != bodySize - header->count * sizeof(Record)){
+        std::cerr << "Snapshot: " << path << " is truncated\n";
+        return false;
+    }
+
+    records = reinterpret_cast<const Record*>(base + sizeof(Header));
+    names = base + sizeof(Header) + header->count * sizeof(Record);
+    if(crc32(base + sizeof(Header), bodySize) != header->bodyCrc){
+        std::cerr << "Snapshot: " << path << " fails its checksum\n";
+        return false;
+    }
+
+    for(size_t i = 0; i < header->count; ++i){
+        const Record& rec = records[i];
+        if(static_cast<uint64_t>(rec.nameOffset) + rec.nameLength > header->namesBytes ||
+           (rec.type != static_cast<uint8_t>(AccountType::SAVINGS) && rec.type != static_cast<uint8_t>(AccountType::CHECKING))){
+            std::cerr << "Snapshot: " << path << " has a malformed record\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Snapshot::size() const {
+    return header ? header->count : 0;
+}
+
+uint64_t Snapshot::journalLsn() const {
+    return header ? header->journalLsn : 0;
+}
+
+AccountImage Snapshot::image(size_t i) const {
+    const Record& rec = records[i];
+    return {static_cast<AccountType>(rec.type), rec.accountNumber,
+            std::string(names + rec.nameOffset, rec.nameLength), rec.balance, rec.rateOrLimit};
+}
+
+void Snapshot::loadInto(AccountRegistry& registry, size_t threads) const {
+    constexpr size_t CHUNK = 16384;
+    std::atomic<size_t> next{0};
+    size_t count = size();
+    registry.reserve(registry.size() + count);
+
+    auto loader = [&](){
+        for(size_t begin = next.fetch_add(CHUNK); begin < count; begin = next.fetch_add(CHUNK)){
+            size_t end = std::min(count, begin + CHUNK);
+            for(size_t i = begin; i < end; ++i){
+                registry.insert(Account::fromImage(image(i)));
+            }
+        }
+    };
+
+    std::vector<std::thread> loaders;
+    for(size_t i = 0; i < std::max<size_t>(1, threads); ++i){
+        loaders.emplace_back(loader);
+    }
+    for(auto& t : loaders){
+        t.join();
+    }
+}
@@ -0,0 +1,230 @@
+#include "WriteBehindQueue.hpp"
+#include "RedisCache.hpp"
+#include "Metrics.hpp"
+#include <future>
+#include <iostream>
+
+WriteBehindQueue::WriteBehindQueue(){
+    // make sure RedisCache, and the Metrics its calls record into, outlive
+    // this queue's final flush at exit
+    Metrics::getInstance();
+    RedisCache::getInstance();
+    worker = std::thread(&WriteBehindQueue::run, this);
+}
+
+WriteBehindQueue::~WriteBehindQueue(){
+    stop();
+}
+
+void WriteBehindQueue::configure(const WriteBehindConfig& newConfig){
+    std::lock_guard<std::mutex> lock(mtx);
+    config = newConfig;
+    ++configGeneration;
+    wakeWorker.notify_one();
+}
+
+void WriteBehindQueue::addLocked(int accNum, Pending update){
+    auto [it, inserted] = pending.try_emplace(accNum, std::move(update));
+    if(!inserted){
+        // a later save supersedes an earlier one, a delete supersedes both
+        it->second.deleteFirst = it->second.deleteFirst || update.deleteFirst;
+        it->second.acc = std::move(update.acc);
+        ++coalesced;
+    }
+    ++enqueued;
+}
+
+void WriteBehindQueue::enqueueSave(const std::shared_ptr<Account>& acc){
+    std::lock_guard<std::mutex> lock(mtx);
+    addLocked(acc->getAccountNumber(), Pending{false, acc});
+    if(pending.size() >= config.maxBatch){
+        wakeWorker.notify_one();
+    }
+}
+
+void WriteBehindQueue::enqueueSaves(const std::vector<std::shared_ptr<Account>>& accs){
+    std::lock_guard<std::mutex> lock(mtx);
+    for(const auto& acc : accs){
+        addLocked(acc->getAccountNumber(), Pending{false, acc});
+    }
+    if(pending.size() >= config.maxBatch){
+        wakeWorker.notify_one();
+    }
+}
+
+void WriteBehindQueue::enqueueDelete(int accNum){
+    std::lock_guard<std::mutex> lock(mtx);
+    addLocked(accNum, Pending{true, nullptr});
+}
+
+bool WriteBehindQueue::enqueueIfDirty(const std::shared_ptr<Account>& acc){
+    if(!acc->isDirty()){
+        ++skippedClean;
+        return false;
+    }
+    enqueueSave(acc);
+    return true;
+}
+
+bool WriteBehindQueue::hasPending(int accNum) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return pending.count(accNum) != 0 || inflight.count(accNum) != 0;
+}
+
+bool WriteBehindQueue::flush(){
+    std::unique_lock<std::mutex> lock(mtx);
+    if(pending.empty() && inflight.empty()){
+        return true; // failed writes are requeued, so nothing is outstanding
+    }
+    if(stopped){
+        return false;
+    }
+    // the pass in flight covers what it swapped out; anything still pending
+    // needs the next one
+    uint64_t target = pending.empty() ? passesStarted : passesStarted + 1;
+    flushRequestedPass = std::max(flushRequestedPass, target);
+    wakeWorker.notify_one();
+    flushed.wait(lock, [this, target]{ return passesDone >= target || stopped; });
+    return passesDone >= target && lastPassOk;
+}
+
+void WriteBehindQueue::stop(){
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if(stopping){
+            return;
+        }
+        stopping = true;
+        wakeWorker.notify_one();
+    }
+    worker.join(); // the worker drains the queue before exiting
+
+    std::lock_guard<std::mutex> lock(mtx);
+    stopped = true;
+    flushed.notify_all();
+}
+
+void WriteBehindQueue::run(){
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while(true){
+        uint64_t waitConfig = configGeneration;
+        wakeWorker.wait_for(lock, config.flushInterval, [this, waitConfig]{
+            return stopping || pending.size() >= config.maxBatch || flushRequestedPass > passesDone ||
+                   configGeneration != waitConfig;
+        });
+        if(configGeneration != waitConfig && !stopping && flushRequestedPass <= passesDone){
+            continue; // wait again under the new interval and batch size
+        }
+
+        if(pending.empty()){
+            if(stopping){
+                return;
+            }
+            continue;
+        }
+
+        inflight.swap(pending);
+        ++passesStarted;
+        size_t maxBatch = config.maxBatch;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        // each account lands in exactly one batch, so the batches are
+        // independent and go out concurrently on pooled connections
+        std::vector<std::future<bool>> writes;
+        std::vector<int> deletes;
+        std::vector<std::shared_ptr<Account>> saves;
+        bool ok = true;
+        for(auto& [accNum, update] : inflight){
+            if(update.deleteFirst){
+                deletes.push_back(accNum);
+            }
+            // a closed account's late updates must not resurrect it, and an
+            // account changed during the previous flush may have had its
+            // latest state written by it already
+            if(update.acc && !update.acc->isClosed()){
+                if(update.acc->isDirty()){
+                    saves.push_back(update.acc); // inflight keeps one too, to requeue on failure
+                }else{
+                    ++skippedClean;
+                }
+            }
+
+            if(deletes.size() + saves.size() >= maxBatch){
+                writes.push_back(RedisCache::getInstance().writeBatchAsync(std::move(deletes), std::move(saves)));
+                deletes.clear();
+                saves.clear();
+            }
+        }
+        if(writes.empty()){
+            ok = RedisCache::getInstance().writeBatch(deletes, saves); // the common small flush
+        }else if(!deletes.empty() || !saves.empty()){
+            writes.push_back(RedisCache::getInstance().writeBatchAsync(std::move(deletes), std::move(saves)));
+        }
+        for(auto& write : writes){
+            ok = write.get() && ok;
+        }
+        saves.clear();
+
+        uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        ++flushes;
+        flushedAccounts += inflight.size();
+        lastFlushUs = us;
+        totalFlushUs += us;
+        if(us > maxFlushUs){
+            maxFlushUs = us;
+        }
+
+        lock.lock();
+        if(!ok){
+            ++failedFlushes;
+            requeueLocked();
+        }
+        inflight.clear(); // nodes go back to the pool, buckets stay
+        // waiters for this pass learn the outcome now rather than after the
+        // retry, which the requeued updates make the next pass do
+        lastPassOk = ok;
+        passesDone = passesStarted;
+        flushed.notify_all();
+        if(stopping && !ok){
+            // the journal still has these changes for the next start
+            std::cerr << "Write-behind: Redis unavailable at shutdown, " << pending.size() << " accounts left to the journal\n";
+            return;
+        }
+    }
+}
+
+void WriteBehindQueue::requeueLocked(){
+    // Redis may have applied part of the failed batches; writing them again
+    // is harmless. Whatever was enqueued since is newer, so it keeps its
+    // state and only inherits the delete
+    for(auto& [accNum, update] : inflight){
+        auto [it, inserted] = pending.try_emplace(accNum, std::move(update));
+        if(!inserted){
+            it->second.deleteFirst = it->second.deleteFirst || update.deleteFirst;
+        }
+    }
+}
+
+json WriteBehindQueue::stats() const {
+    size_t depth;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        depth = pending.size();
+    }
+
+    uint64_t flushCount = flushes.load();
+    return {
+        {"queueDepth", depth},
+        {"enqueued", enqueued.load()},
+        {"coalesced", coalesced.load()},
+        {"skippedClean", skippedClean.load()},
+        {"failedFlushes", failedFlushes.load()},
+        {"flushes", flushCount},
+        {"flushedAccounts", flushedAccounts.load()},
+        {"lastFlushMs", lastFlushUs.load() / 1000.0},
+        {"avgFlushMs", flushCount ? totalFlushUs.load() / 1000.0 / flushCount : 0.0},
+        {"maxFlushMs", maxFlushUs.load() / 1000.0}
+    };
+}